@@ -0,0 +1,26 @@
+#ifndef BENCH_UTILS_H
+#define BENCH_UTILS_H
+//helpers shared by the benchmarks that render without a window
+#include "glad/glad.h"
+
+#include "scene.h"
+#include "headless.h"
+
+//random number in [low, high), the sequence is the same on every run
+inline float randomRange(float low, float high)
+{
+	static unsigned int state = 1;
+	state = state * 1664525u + 1013904223u;
+	return low + (high - low) * float(state >> 8) / float(1u << 24);
+}
+
+//draw a frame into the off screen framebuffer, the GPU may still be working on it afterwards
+inline void renderFrame(Scene &scene, HeadlessContext &context)
+{
+	context.bind();
+	glClearColor(0, 0, 0, 1.0f);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+	scene.render();
+}
+
+#endif
@@ -0,0 +1,452 @@
+//this is a deterministic frame benchmark, it renders without a window
+//a scene description is loaded, then the camera flies along its recorded path with a fixed
+//timestep for a fixed number of frames. Textures are decoded before the first frame, so every
+//run renders the same frames. The report is written as JSON:
+//	cpu_frame_ms: time spent in render() on the CPU, percentiles over all frames
+//	gpu_frame_ms: time the GPU spent on each frame, measured by GL_TIME_ELAPSED queries
+//	draw_calls, uniform_calls, material_binds, ...: averages per frame, see RenderStats
+//usage: ogl_advance_bench [scene description] [report.json]
+//	the default description is resources/scenes/bench.txt, the report is written to
+//	bench_report.json in the working directory
+//
+//a scene description is text, one command per line, lines starting with # are comments
+//settings:
+//	size width height
+//	frames n			frames measured
+//	warmup n			frames rendered before measuring
+//	timestep seconds	camera time between two frames
+//	shading forward|deferred
+//	transparency sorted|oit
+//	culling on|off
+//objects, tex is an image in resources/textures or - for no texture, transform is
+//"x y z [sx sy sz [angle ax ay az]]":
+//	cube tex transform
+//	plane tex transform
+//	model path transform			path is relative to resources/objects
+//	cubes tex nx nz x y z spacing	a grid of cubes, each one is a model
+//	instanced_cubes tex nx nz x y z spacing		the same grid drawn as one instanced model
+//lights:
+//	dirlight dx dy dz
+//	pointlight x y z range
+//	pointlights n x0 y0 z0 x1 y1 z1 range		random point lights inside a box
+//	spotlight x y z dx dy dz inner outer
+//camera:
+//	key time x y z yaw pitch		see cameraPath.h
+//	path file						keys of a recorded path, relative to the description
+#define STB_IMAGE_IMPLEMENTATION
+#include "glad/glad.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <algorithm>
+#include <cstdlib>
+#include <memory>
+
+#include "scene.h"
+#include "headless.h"
+#include "cameraPath.h"
+#include "benchUtils.h"
+
+using namespace std;
+using namespace glm;
+
+//a line of the description
+struct Command {
+	unsigned int line;
+	string name;
+	istringstream args;
+
+	Command(unsigned int line, const string &text) : line(line), args(text) {args >> name;}
+};
+
+struct BenchSettings {
+	unsigned int width, height;
+	unsigned int frames, warmup;
+	float timestep;
+	SHADING_MODE shading;
+	TRANSPARENCY_MODE transparency;
+	bool culling;
+
+	BenchSettings() : width(1280), height(720), frames(300), warmup(10), timestep(1.0f / 60.0f),
+		shading(FORWARD_SHADING), transparency(SORTED_TRANSPARENCY), culling(true) {}
+};
+
+//statistics of all measured frames
+struct BenchResults {
+	string renderer;
+	vector<double> cpu_ms;
+	vector<double> gpu_ms;
+	double draws, culled, draw_calls, uniform_calls, material_binds, state_changes,
+		state_changes_avoided;
+
+	BenchResults() : draws(0), culled(0), draw_calls(0), uniform_calls(0), material_binds(0),
+		state_changes(0), state_changes_avoided(0) {}
+};
+
+static void invalidLine(const Command &command)
+{
+	cout << "ERROR::BENCH::INVALID_COMMAND: line " << command.line << ": " << command.name
+		<< endl;
+}
+
+//read "x y z [sx sy sz [angle ax ay az]]" and apply it to a model
+static bool readTransform(Command &command, Scene &scene, SceneID id)
+{
+	vec3 pos, scale, axis;
+	float angle;
+	if (!(command.args >> pos.x >> pos.y >> pos.z))
+		return false;
+	scene.setModelPos(id, pos);
+	if (command.args >> scale.x >> scale.y >> scale.z)
+		scene.setModelScale(id, scale);
+	if (command.args >> angle >> axis.x >> axis.y >> axis.z)
+		scene.setModelRotate(id, angle, axis);
+	return true;
+}
+
+//first pass over the description, settings are needed before the scene is created
+static bool readSettings(vector<unique_ptr<Command> > &commands, BenchSettings &settings)
+{
+	for (unsigned int i = 0; i < commands.size(); i ++)
+	{
+		Command &command = *commands[i];
+		string mode;
+		bool valid = true;
+		if (command.name == "size")
+			valid = bool(command.args >> settings.width >> settings.height) && settings.width > 0 &&
+				settings.height > 0;
+		else if (command.name == "frames")
+			valid = bool(command.args >> settings.frames) && settings.frames > 0;
+		else if (command.name == "warmup")
+			valid = bool(command.args >> settings.warmup);
+		else if (command.name == "timestep")
+			valid = bool(command.args >> settings.timestep);
+		else if (command.name == "shading")
+		{
+			valid = bool(command.args >> mode) && (mode == "forward" || mode == "deferred");
+			settings.shading = mode == "deferred" ? DEFERRED_SHADING : FORWARD_SHADING;
+		}
+		else if (command.name == "transparency")
+		{
+			valid = bool(command.args >> mode) && (mode == "sorted" || mode == "oit");
+			settings.transparency = mode == "oit" ? WEIGHTED_OIT : SORTED_TRANSPARENCY;
+		}
+		else if (command.name == "culling")
+		{
+			valid = bool(command.args >> mode) && (mode == "on" || mode == "off");
+			settings.culling = mode == "on";
+		}
+		else
+			continue;
+		if (!valid)
+		{
+			invalidLine(command);
+			return false;
+		}
+	}
+	return true;
+}
+
+//second pass, add objects, lights and camera keys
+static bool readObjects(vector<unique_ptr<Command> > &commands, const string &resources,
+	const string &description_dir, Scene &scene, CameraPath &path)
+{
+	Material material(vec3(0.2f), vec3(0.7f), vec3(0.3f), 16.0f);
+	for (unsigned int i = 0; i < commands.size(); i ++)
+	{
+		Command &command = *commands[i];
+		const string &name = command.name;
+		bool valid = true;
+		string tex;
+		vector<string> tex_paths;
+		//objects with textures use the same image for every type
+		if (name == "cube" || name == "plane" || name == "cubes" || name == "instanced_cubes")
+		{
+			valid = bool(command.args >> tex);
+			if (valid && tex != "-")
+				tex_paths.assign(3, resources + "/textures/" + tex);
+		}
+
+		if (!valid)
+			;
+		else if (name == "cube" || name == "plane")
+		{
+			SceneID id = name == "cube" ? scene.addCube(material, tex_paths) :
+				scene.addPlane(material, tex_paths);
+			valid = readTransform(command, scene, id);
+		}
+		else if (name == "model")
+		{
+			string file;
+			valid = bool(command.args >> file);
+			if (valid)
+				valid = readTransform(command, scene,
+					scene.addModel(resources + "/objects/" + file));
+		}
+		else if (name == "cubes" || name == "instanced_cubes")
+		{
+			unsigned int nx, nz;
+			vec3 origin;
+			float spacing;
+			valid = bool(command.args >> nx >> nz >> origin.x >> origin.y >> origin.z >> spacing);
+			InstancedModel *instanced = NULL;
+			if (valid && name == "instanced_cubes")
+				instanced = scene.getInstancedModel(scene.addInstancedCube(material, tex_paths));
+			for (unsigned int j = 0; valid && j < nx * nz; j ++)
+			{
+				vec3 pos = origin + vec3(float(j % nx), 0.0f, -float(j / nx)) * spacing;
+				if (instanced)
+					instanced->addInstance(pos);
+				else
+					scene.setModelPos(scene.addCube(material, tex_paths), pos);
+			}
+		}
+		else if (name == "dirlight")
+		{
+			vec3 dir;
+			valid = bool(command.args >> dir.x >> dir.y >> dir.z);
+			if (valid)
+				scene.addDirLight(vec3(1.0f), dir, vec3(0.1f), vec3(0.5f), vec3(0.5f));
+		}
+		else if (name == "pointlight")
+		{
+			vec3 pos;
+			float range;
+			valid = bool(command.args >> pos.x >> pos.y >> pos.z >> range);
+			if (valid)
+				scene.addPointLight(pos, range);
+		}
+		else if (name == "pointlights")
+		{
+			unsigned int n;
+			vec3 low, high;
+			float range;
+			valid = bool(command.args >> n >> low.x >> low.y >> low.z >> high.x >> high.y
+				>> high.z >> range);
+			for (unsigned int j = 0; valid && j < n; j ++)
+			{
+				vec3 color(randomRange(0.2f, 1.0f), randomRange(0.2f, 1.0f),
+					randomRange(0.2f, 1.0f));
+				vec3 pos(randomRange(low.x, high.x), randomRange(low.y, high.y),
+					randomRange(low.z, high.z));
+				scene.addPointLight(color, pos, vec3(0.0f), vec3(0.8f), vec3(0.5f), range);
+			}
+		}
+		else if (name == "spotlight")
+		{
+			vec3 pos, dir;
+			float inner, outer;
+			valid = bool(command.args >> pos.x >> pos.y >> pos.z >> dir.x >> dir.y >> dir.z
+				>> inner >> outer);
+			if (valid)
+				scene.addSpotLight(dir, pos, inner, outer);
+		}
+		else if (name == "key")
+		{
+			float time, yaw, pitch;
+			vec3 pos;
+			valid = bool(command.args >> time >> pos.x >> pos.y >> pos.z >> yaw >> pitch) &&
+				path.addKey(time, pos, yaw, pitch);
+		}
+		else if (name == "path")
+		{
+			string file;
+			valid = bool(command.args >> file) && path.load(description_dir + "/" + file);
+		}
+		else if (name != "size" && name != "frames" && name != "warmup" && name != "timestep" &&
+			name != "shading" && name != "transparency" && name != "culling")
+			valid = false;
+
+		if (!valid)
+		{
+			invalidLine(command);
+			return false;
+		}
+	}
+	return true;
+}
+
+static void run(Scene &scene, HeadlessContext &context, const CameraPath &path,
+	const BenchSettings &settings, BenchResults &results)
+{
+	results.renderer = (const char*)glGetString(GL_RENDERER);
+	Camera &camera = *scene.getCamera();
+	for (unsigned int f = 0; f < settings.warmup; f ++)
+	{
+		path.apply(f * settings.timestep, camera);
+		renderFrame(scene, context);
+	}
+	glFinish();
+
+	//every frame has its own query, results are read after the last frame so that the
+	//benchmark never waits for the GPU in between
+	vector<GLuint> queries(settings.frames);
+	glGenQueries(settings.frames, &queries[0]);
+	results.cpu_ms.resize(settings.frames);
+	for (unsigned int f = 0; f < settings.frames; f ++)
+	{
+		path.apply((settings.warmup + f) * settings.timestep, camera);
+		glBeginQuery(GL_TIME_ELAPSED, queries[f]);
+		auto start = chrono::steady_clock::now();
+		renderFrame(scene, context);
+		results.cpu_ms[f] = chrono::duration<double, milli>(chrono::steady_clock::now() -
+			start).count();
+		glEndQuery(GL_TIME_ELAPSED);
+
+		const RenderStats &stats = scene.getStats();
+		results.draws += stats.draws;
+		results.culled += stats.culled;
+		results.draw_calls += stats.draw_calls;
+		results.uniform_calls += stats.uniform_calls;
+		results.material_binds += stats.material_binds;
+		results.state_changes += stats.state_changes;
+		results.state_changes_avoided += stats.state_changes_avoided;
+	}
+	glFinish();
+
+	results.gpu_ms.resize(settings.frames);
+	for (unsigned int f = 0; f < settings.frames; f ++)
+	{
+		GLuint64 ns = 0;
+		glGetQueryObjectui64v(queries[f], GL_QUERY_RESULT, &ns);
+		results.gpu_ms[f] = ns / 1e6;
+	}
+	glDeleteQueries(settings.frames, &queries[0]);
+}
+
+//write percentiles of frame times as a JSON object
+static void writeTimes(ostream &out, vector<double> times)
+{
+	sort(times.begin(), times.end());
+	double sum = 0;
+	for (unsigned int i = 0; i < times.size(); i ++)
+		sum += times[i];
+	//nearest rank
+	const double percentiles[] = {50, 90, 95, 99};
+	out << "{\"mean\": " << sum / times.size() << ", \"min\": " << times.front();
+	for (unsigned int i = 0; i < 4; i ++)
+	{
+		unsigned int rank = (unsigned int)(percentiles[i] / 100.0 * times.size() + 0.999999);
+		rank = std::max(1u, std::min(rank, (unsigned int)times.size()));
+		out << ", \"p" << percentiles[i] << "\": " << times[rank - 1];
+	}
+	out << ", \"max\": " << times.back() << "}";
+}
+
+//write a string as a JSON string, quotes, backslashes and control characters are escaped
+static void writeString(ostream &out, const string &text)
+{
+	const char *hex = "0123456789abcdef";
+	out << '"';
+	for (unsigned int i = 0; i < text.size(); i ++)
+	{
+		unsigned char c = text[i];
+		if (c == '"' || c == '\\')
+			out << '\\' << c;
+		else if (c < 0x20)
+			out << "\\u00" << hex[c >> 4] << hex[c & 15];
+		else
+			out << c;
+	}
+	out << '"';
+}
+
+static void writeReport(ostream &out, const string &description, const BenchSettings &settings,
+	const BenchResults &results)
+{
+	double frames = settings.frames;
+	out << "{" << endl;
+	out << "\t\"scene\": ";
+	writeString(out, description);
+	out << "," << endl << "\t\"renderer\": ";
+	writeString(out, results.renderer);
+	out << "," << endl;
+	out << "\t\"width\": " << settings.width << "," << endl;
+	out << "\t\"height\": " << settings.height << "," << endl;
+	out << "\t\"frames\": " << settings.frames << "," << endl;
+	out << "\t\"timestep\": " << settings.timestep << "," << endl;
+	out << "\t\"shading\": \"" << (settings.shading == DEFERRED_SHADING ? "deferred" : "forward")
+		<< "\"," << endl;
+	out << "\t\"cpu_frame_ms\": ";
+	writeTimes(out, results.cpu_ms);
+	out << "," << endl << "\t\"gpu_frame_ms\": ";
+	writeTimes(out, results.gpu_ms);
+	out << "," << endl;
+	out << "\t\"models_drawn\": " << results.draws / frames << "," << endl;
+	out << "\t\"models_culled\": " << results.culled / frames << "," << endl;
+	out << "\t\"draw_calls\": " << results.draw_calls / frames << "," << endl;
+	out << "\t\"uniform_calls\": " << results.uniform_calls / frames << "," << endl;
+	out << "\t\"material_binds\": " << results.material_binds / frames << "," << endl;
+	out << "\t\"state_changes\": " << results.state_changes / frames << "," << endl;
+	out << "\t\"state_changes_avoided\": " << results.state_changes_avoided / frames << endl;
+	out << "}" << endl;
+}
+
+int main(int argc, char *argv[])
+{
+	const string curr_dir = string(argv[0]).substr(0, string(argv[0]).find_last_of('/'));
+	const string resources = curr_dir + "/../resources";
+	string description = argc > 1 ? argv[1] : resources + "/scenes/bench.txt";
+	string report = argc > 2 ? argv[2] : "bench_report.json";
+	if (argc > 3)
+	{
+		cout << "usage: ogl_advance_bench [scene description] [report.json]" << endl;
+		return 1;
+	}
+
+	ifstream file(description.c_str());
+	if (!file)
+	{
+		cout << "ERROR::BENCH::FILE_NOT_SUCCESFULLY_READ: " << description << endl;
+		return 1;
+	}
+	vector<unique_ptr<Command> > commands;
+	string line;
+	for (unsigned int i = 1; getline(file, line); i ++)
+	{
+		unique_ptr<Command> command(new Command(i, line));
+		if (!command->name.empty() && command->name[0] != '#')
+			commands.push_back(move(command));
+	}
+
+	BenchSettings settings;
+	BenchResults results;
+	bool valid = readSettings(commands, settings);
+	if (valid)
+	{
+		HeadlessContext context(settings.width, settings.height);
+		valid = context.valid();
+		if (valid)
+		{
+			initGLState();
+			//textures are ready before the first frame, so every run is the same
+			TextureCache::setAsync(false);
+
+			Scene scene(curr_dir, vec3(0, 1, 3), settings.width, settings.height);
+			scene.setShading(settings.shading);
+			scene.setTransparency(settings.transparency);
+			scene.setCulling(settings.culling);
+			CameraPath path;
+			//camera paths are relative to the description, which may be in the working directory
+			size_t slash = description.find_last_of('/');
+			string description_dir = slash == string::npos ? "." : description.substr(0, slash);
+			valid = readObjects(commands, resources, description_dir, scene, path);
+			if (valid)
+				run(scene, context, path, settings, results);
+			MaterialRegistry::clear();
+		}
+	}
+	if (!valid)
+		return 1;
+
+	ofstream out(report.c_str());
+	writeReport(out, description, settings, results);
+	if (!out)
+	{
+		cout << "ERROR::BENCH::REPORT_NOT_WRITTEN: " << report << endl;
+		return 1;
+	}
+	writeReport(cout, description, settings, results);
+	return 0;
+}
@@ -0,0 +1,109 @@
+//this is a benchmark of forward and deferred shading, it renders without a window
+//rows of cubes are placed one behind another so that many fragments are covered, then the
+//scene is rendered with 10, 100 and 1000 point lights spread over the cubes:
+//	forward: every fragment drawn is lit by the lights of its cluster, see General.fs
+//	deferred: surfaces are drawn into the G-buffer, then every pixel is lit once
+//each frame is finished with glFinish, so the time includes the GPU
+//usage: shading_bench [frames]
+#define STB_IMAGE_IMPLEMENTATION
+#include "glad/glad.h"
+#include <iostream>
+#include <chrono>
+#include <cstdlib>
+
+#include "scene.h"
+#include "headless.h"
+#include "benchUtils.h"
+
+using namespace std;
+using namespace glm;
+
+const unsigned int BENCH_WIDTH = 1280;
+const unsigned int BENCH_HEIGHT = 720;
+
+//render a frame and wait for the GPU to finish it
+static void finishFrame(Scene &scene, HeadlessContext &context)
+{
+	renderFrame(scene, context);
+	glFinish();
+}
+
+//render frames in a shading mode, return milliseconds per frame
+static double benchShading(Scene &scene, HeadlessContext &context, SHADING_MODE mode,
+	unsigned int frames)
+{
+	scene.setShading(mode);
+	//the first frames compile programs and upload lights
+	for (unsigned int f = 0; f < 3; f ++)
+		finishFrame(scene, context);
+
+	auto start = chrono::steady_clock::now();
+	for (unsigned int f = 0; f < frames; f ++)
+		finishFrame(scene, context);
+	return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count() / frames;
+}
+
+int main(int argc, char *argv[])
+{
+	unsigned int frames = argc > 1 ? atoi(argv[1]) : 50;
+	if (frames == 0)
+	{
+		cout << "usage: shading_bench [frames]" << endl;
+		return 1;
+	}
+	HeadlessContext context(BENCH_WIDTH, BENCH_HEIGHT);
+	if (!context.valid())
+		return 1;
+	initGLState();
+
+	const string curr_dir = string(argv[0]).substr(0, string(argv[0]).find_last_of('/'));
+	Scene scene(curr_dir, vec3(0, 2, 4), BENCH_WIDTH, BENCH_HEIGHT);
+	scene.setShading(DEFERRED_SHADING);
+	if (scene.getShading() != DEFERRED_SHADING)
+		return 1;
+
+	//cubes without textures, 16 columns and 12 rows going away from the camera
+	Material cube_mat(vec3(0.2f), vec3(0.8f), vec3(0.5f), 16.0f);
+	vector<string> no_tex;
+	for (unsigned int i = 0; i < 16 * 12; i ++)
+	{
+		SceneID cube = scene.addCube(cube_mat, no_tex);
+		scene.setModelPos(cube, vec3(float(i % 16) - 7.5f, 0.5f, -float(i / 16) * 1.5f));
+		scene.setModelScale(cube, vec3(0.8f, 1.0f + float(i % 3), 0.8f));
+	}
+	Material ground_mat(vec3(0.2f), vec3(0.6f), vec3(0.2f), 8.0f);
+	SceneID ground = scene.addPlane(ground_mat, no_tex);
+	scene.setModelScale(ground, vec3(40.0f));
+	scene.addDirLight(vec3(1.0f), vec3(-0.2f, -1.0f, -0.3f), vec3(0.1f), vec3(0.2f), vec3(0.2f));
+
+	cout << frames << " frames at " << BENCH_WIDTH << "x" << BENCH_HEIGHT << ", "
+		<< glGetString(GL_RENDERER) << endl;
+	const unsigned int counts[] = {10, 100, 1000};
+	unsigned int lights = 0;
+	for (unsigned int c = 0; c < 3; c ++)
+	{
+		for (; lights < counts[c]; lights ++)
+		{
+			vec3 color(randomRange(0.2f, 1.0f), randomRange(0.2f, 1.0f),
+				randomRange(0.2f, 1.0f));
+			vec3 pos(randomRange(-8.0f, 8.0f), randomRange(0.2f, 3.0f),
+				randomRange(-18.0f, 1.0f));
+			scene.addPointLight(color, pos, vec3(0.0f), vec3(0.8f), vec3(0.5f), 3.0f);
+		}
+		double forward_ms = benchShading(scene, context, FORWARD_SHADING, frames);
+		double deferred_ms = benchShading(scene, context, DEFERRED_SHADING, frames);
+		cout << lights << " point lights:" << endl;
+		cout << "\tforward:\t" << forward_ms << " ms/frame" << endl;
+		cout << "\tdeferred:\t" << deferred_ms << " ms/frame (" << forward_ms / deferred_ms
+			<< "x)" << endl;
+	}
+
+	MaterialRegistry::clear();
+	GLenum error = glGetError();
+	if (error != GL_NO_ERROR)
+	{
+		cout << "ERROR::GL::" << error << endl;
+		return 1;
+	}
+	return 0;
+}
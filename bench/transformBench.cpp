@@ -0,0 +1,149 @@
+//this is a benchmark of model transformations, it doesn't need a GL context
+//100k objects are moved every frame, rebuilding their model matrices:
+//	per object: translation, rotation and scaling kept in every model, the matrix rebuilt by
+//		glm::translate, glm::rotate and glm::scale after each setter, as Model did before
+//	store: TransformStore, matrices rebuilt once per frame for changed objects only
+//usage: transform_bench [objects] [frames]
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <cstdlib>
+
+#include "glm/glm.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+#include "transformStore.h"
+
+using namespace std;
+using namespace glm;
+
+//transformation of one object in the per object layout
+struct ObjectTransform {
+	mat4 model;
+	vec3 pos, rotate, scale;
+	float rotate_angle;
+
+	void calcModelView()
+	{
+		model = glm::translate(mat4(1.0f), pos);
+		model = glm::rotate(model, radians(rotate_angle), rotate);
+		model = glm::scale(model, scale);
+	}
+};
+
+//position, rotation and scaling of object i in a frame
+static vec3 framePos(unsigned int i, unsigned int frame)
+{
+	return vec3(float(i % 1000), float(frame), float(i / 1000) * 0.5f);
+}
+
+static float frameAngle(unsigned int i, unsigned int frame)
+{
+	return float((i * 7 + frame * 13) % 360);
+}
+
+static vec3 frameAxis(unsigned int i)
+{
+	return vec3(float(i % 3), 1.0f, float(i % 5) + 0.5f);
+}
+
+static vec3 frameScale(unsigned int i)
+{
+	return vec3(1.0f + float(i % 4) * 0.25f);
+}
+
+static double millisecondsSince(chrono::steady_clock::time_point start)
+{
+	return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+//move every step-th object, then rebuild, return milliseconds per frame
+static double benchObjects(vector<ObjectTransform> &objects, unsigned int frames,
+	unsigned int step)
+{
+	auto start = chrono::steady_clock::now();
+	for (unsigned int f = 0; f < frames; f ++)
+	{
+		for (unsigned int i = 0; i < objects.size(); i += step)
+		{
+			//every setter of Model recalculated the model matrix
+			ObjectTransform &object = objects[i];
+			object.pos = framePos(i, f);
+			object.calcModelView();
+			object.rotate = frameAxis(i);
+			object.rotate_angle = frameAngle(i, f);
+			object.calcModelView();
+			object.scale = frameScale(i);
+			object.calcModelView();
+		}
+	}
+	return millisecondsSince(start) / frames;
+}
+
+static double benchStore(TransformStore &store, unsigned int count, unsigned int frames,
+	unsigned int step)
+{
+	vector<unsigned int> changed;
+	auto start = chrono::steady_clock::now();
+	for (unsigned int f = 0; f < frames; f ++)
+	{
+		changed.clear();
+		for (unsigned int i = 0; i < count; i += step)
+		{
+			store.setPosition(i, framePos(i, f));
+			store.setRotation(i, frameAngle(i, f), frameAxis(i));
+			store.setScale(i, frameScale(i));
+		}
+		store.update(changed);
+	}
+	return millisecondsSince(start) / frames;
+}
+
+int main(int argc, char *argv[])
+{
+	unsigned int count = argc > 1 ? atoi(argv[1]) : 100000;
+	unsigned int frames = argc > 2 ? atoi(argv[2]) : 100;
+	if (count == 0 || frames == 0)
+	{
+		cout << "usage: transform_bench [objects] [frames]" << endl;
+		return 1;
+	}
+
+	vector<ObjectTransform> objects(count);
+	TransformStore store;
+	for (unsigned int i = 0; i < count; i ++)
+	{
+		objects[i].pos = vec3(0.0f);
+		objects[i].rotate = vec3(1.0f);
+		objects[i].rotate_angle = 0.0f;
+		objects[i].scale = vec3(1.0f);
+		objects[i].calcModelView();
+		store.add();
+	}
+
+	cout << count << " objects, " << frames << " frames" << endl;
+	const unsigned int steps[] = {1, 10};
+	for (unsigned int s = 0; s < 2; s ++)
+	{
+		double object_ms = benchObjects(objects, frames, steps[s]);
+		double store_ms = benchStore(store, count, frames, steps[s]);
+		cout << "moving 1/" << steps[s] << " of objects:" << endl;
+		cout << "\tper object:\t" << object_ms << " ms/frame" << endl;
+		cout << "\tstore:\t\t" << store_ms << " ms/frame (" << object_ms / store_ms
+			<< "x)" << endl;
+	}
+
+	//both layouts should end with the same matrices
+	float max_error = 0.0f;
+	for (unsigned int i = 0; i < count; i ++)
+	{
+		const mat4 &a = objects[i].model;
+		const mat4 &b = store.getMatrix(i);
+		for (unsigned int c = 0; c < 4; c ++)
+		{
+			for (unsigned int r = 0; r < 4; r ++)
+				max_error = glm::max(max_error, glm::abs(a[c][r] - b[c][r]));
+		}
+	}
+	cout << "max matrix difference: " << max_error << endl;
+	return max_error < 1e-3f ? 0 : 1;
+}
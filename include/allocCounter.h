@@ -0,0 +1,13 @@
+#ifndef ALLOC_COUNTER_H
+#define ALLOC_COUNTER_H
+//this file contains a process-wide heap allocation counter
+//global operator new is replaced in allocCounter.cpp so that every heap allocation made by
+//this program (including the ones inside std containers) is counted
+
+//get the number of heap allocations since the program started
+//POST:
+//	the returned value only grows, take the difference of two calls to count the allocations
+//	made between them
+unsigned long getAllocCount();
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef BOUNDS_H
+#define BOUNDS_H
+//this file contains bounding volumes of meshes and models, and the view frustum used to
+//cull them
+#include "glm/glm.hpp"
+
+//axis aligned bounding box together with a bounding sphere
+//the sphere is tested first since it is cheaper, the box rejects what the sphere can't
+struct Bounds {
+	glm::vec3 min;
+	glm::vec3 max;
+	glm::vec3 center;	//center of the sphere, same as the center of the box
+	float radius;		//negative if nothing is bounded
+
+	//empty bounds, expand() or merge() them to bound something
+	Bounds() : min(0.0f), max(0.0f), center(0.0f), radius(-1.0f) {}
+
+	//whether nothing is bounded
+	bool empty() const {return radius < 0;}
+
+	//bound a set of points
+	//PRE:
+	//	positions: first point, points are stride bytes apart
+	//	num: number of points
+	//	stride: bytes between two points
+	void calc(const glm::vec3 *positions, unsigned int num, unsigned int stride);
+
+	//bound another bounds as well as the current one
+	void merge(const Bounds &other);
+
+	//transform the bounds by a matrix
+	//POST:
+	//	return bounds of the transformed volume. The box still bounds every transformed point
+	//	but may be larger than the box of the transformed points
+	Bounds transform(const glm::mat4 &mat) const;
+};
+
+//six planes of a view frustum, normals point inside
+struct Frustum {
+	glm::vec4 planes[6];	//left, right, bottom, top, near, far
+
+	Frustum() {}
+	//extract planes from a projection * view matrix, the planes are in world space
+	Frustum(const glm::mat4 &proj_view);
+
+	//whether any part of the bounds might be inside the frustum
+	//POST:
+	//	return false if bounds are empty or completely outside of one plane
+	bool intersects(const Bounds &bounds) const;
+};
+
+#endif
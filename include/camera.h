@@ -27,6 +27,17 @@ const float INIT_PITCH = 0.0;
 const float INIT_SPEED = 2.5;
 const float INIT_MOUSE_SENSITIVITY = 0.05;
 
+//std140 layout of the Camera uniform block shared by General.vs and General.fs
+//this block is filled once per frame by the scene
+struct CameraBlock {
+	glm::mat4 view;
+	glm::mat4 proj;
+	glm::vec3 viewPos;
+	float pad;
+};
+
+static_assert(sizeof(CameraBlock) == 144, "CameraBlock doesn't match std140 layout");
+
 class Camera {
 public:
 	GLboolean MOUSE_VERTICAL_INVERSE;
@@ -77,6 +88,13 @@ public:
 	glm::mat4 getView();
 	//fov getter
 	float getFOV();
+	//place the camera and turn it, used to replay a recorded camera path
+	//PRE:
+	//	yaw, pitch: angles in degrees, the same ones changed by mouse movement
+	void setPose(glm::vec3 position, float yaw, float pitch);
+	//angles of the camera in degrees
+	float getYaw() {return _yaw;}
+	float getPitch() {return _pitch;}
 	//speed setter, note original camera speed is 2.5f
 	void setSpeed(float speed);
 	//mouse sensitivity setter
@@ -0,0 +1,50 @@
+#ifndef CAMERA_PATH_H
+#define CAMERA_PATH_H
+//this is a path of the camera through recorded poses
+//the camera passes every key at its time, poses between two keys follow a Catmull-Rom spline
+//so that the camera moves without sudden turns. A path is saved as text, one key per line:
+//	key time x y z yaw pitch
+//lines starting with # are comments
+#include <string>
+#include <vector>
+
+#include "glm/glm.hpp"
+#include "camera.h"
+
+class CameraPath
+{
+public:
+	//a recorded pose of the camera
+	struct Key {
+		float time;			//seconds from the start of the path
+		glm::vec3 position;
+		float yaw, pitch;	//degrees, see Camera
+	};
+
+	//add a key at the end of the path
+	//POST:
+	//	return false if the key is earlier than the last key, the key is not added
+	bool addKey(float time, const glm::vec3 &position, float yaw, float pitch);
+	//record the current pose of a camera
+	bool addKey(float time, Camera &camera);
+
+	//read keys from a file and add them to the path
+	//POST:
+	//	return false if the file can't be read or a line is not a key
+	bool load(const std::string &path);
+	//write every key into a file
+	bool save(const std::string &path) const;
+
+	//move the camera to its pose at a time, times out of the path are clamped
+	//nothing is done if the path has no key
+	void apply(float time, Camera &camera) const;
+
+	//time of the last key
+	float duration() const {return keys.empty() ? 0.0f : keys.back().time;}
+	unsigned int size() const {return keys.size();}
+
+private:
+	std::vector<Key> keys;
+};
+
+#endif
@@ -14,6 +14,9 @@
 #include "glm/gtc/type_ptr.hpp"
 
 #include "scene.h"
+#include "headless.h"
+#include "cameraPath.h"
+#include "glTrace.h"
 #include "utils.h"
 
 using namespace std;
@@ -26,6 +29,14 @@ extern Camera *camera;
 //initilize the window and glad
 GLFWwindow* initWindow(unsigned int SCR_WIDTH, unsigned int SCR_HEIGHT, const std::string name);
 
+//initilize an off screen context and glad, for machines without a display
+//PRE:
+//	SCR_WIDTH, SCR_HEIGHT: size of the rendered frames
+//POST:
+//	return NULL if the context can't be created
+//	the context is deleted with the returned object
+HeadlessContext* initHeadless(unsigned int SCR_WIDTH, unsigned int SCR_HEIGHT);
+
 //process user input in the render loop
 //PRE:
 // window: user's window
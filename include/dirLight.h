@@ -26,8 +26,8 @@ public:
 	DirLight(glm::vec3 color, glm::vec3 direction, glm::vec3 ambient, glm::vec3 diffuse, 
 		glm::vec3 specular) : Light(color, direction, glm::vec3(0.0), ambient, diffuse, specular){}
 
-	//send all vectors to a specific shader with light's name
-	void sendShader(Shader &shader, const std::string &name) const override;
+	//write this light into its slot of the Lights uniform block
+	void fillBlock(DirLightBlock &block) const;
 };
 
 
@@ -0,0 +1,56 @@
+#ifndef G_BUFFER_H
+#define G_BUFFER_H
+//this is the off screen buffer of deferred shading
+//opaque models are drawn once into the G-buffer without any light, the surface of the
+//closest fragment of every pixel is kept in these targets:
+//	position (RGBA32F): xyz is the world position, w is 1 where a surface is drawn
+//	normal (RGBA16F): xyz is the world normal, w is the shininess
+//	ambient, albedo, specular (RGBA16F): colors of the material, textures are already sampled
+//then every pixel is lit once by a full screen pass, so the cost of lights doesn't grow with
+//overdraw. Point and spot lights are read from the clusters of the pixel like the forward
+//path, see lightClusters.h
+//both passes are variants of General.fs, GBUFFER and DEFERRED_LIGHTING
+#include "glad/glad.h"
+#include "shader.h"
+#include "glState.h"
+#include "renderTarget.h"
+
+//number of color targets of the G-buffer
+const unsigned int G_BUFFER_TARGETS = 5;
+
+class GBuffer
+{
+public:
+	//PRE:
+	//	width, height: size of the target framebuffer
+	//	lighting: shader of the lighting pass, Screen.vs and General.fs with DEFERRED_LIGHTING
+	GBuffer(unsigned int width, unsigned int height, Shader &lighting);
+	~GBuffer();
+	GBuffer(const GBuffer&) = delete;
+	GBuffer& operator=(const GBuffer&) = delete;
+
+	//whether the framebuffer is complete, nothing should be drawn with it otherwise
+	bool valid() const {return complete;}
+
+	//clear the buffer and start drawing opaque models into it with GBUFFER programs
+	//blending is disabled until end(), colors of the targets are not blended
+	void begin();
+	//light every pixel of the buffer onto the framebuffer bound before begin()
+	//the depth buffer is copied to that framebuffer, so the target framebuffer should have a
+	//24 bits depth and 8 bits stencil buffer of the same size. Models drawn afterwards are
+	//still hidden by the opaque ones
+	//blending is restored to the state set by initWindow()
+	void end();
+
+private:
+	unsigned int width, height;
+	unsigned int fbo;
+	unsigned int targets[G_BUFFER_TARGETS];	//color textures
+	unsigned int depth;						//depth and stencil renderbuffer
+	unsigned int empty_vao;					//full screen pass has no vertex attribute
+	int target;								//framebuffer bound before begin()
+	bool complete;
+	Shader *lighting;
+};
+
+#endif
@@ -0,0 +1,66 @@
+#ifndef GL_STATE_H
+#define GL_STATE_H
+//this is a cache of the GL objects bound between draw calls
+//binding an object that is already bound is skipped. Every program, texture and vertex array
+//binding should go through this class, otherwise the cache is out of date. Call invalidate()
+//after binding any of them directly
+#include "glad/glad.h"
+
+//number of texture units whose bindings are cached, binds to higher units are never skipped
+const unsigned int CACHED_TEXTURE_UNITS = 17;
+
+//number of binds made and skipped since the last resetChanges()
+//draw calls, uniform updates and material binds are counted here as well, they are reported
+//by drawCalled(), uniformSet() and materialBound()
+struct StateChanges {
+	unsigned int programs;		//glUseProgram calls
+	unsigned int textures;		//glBindTexture calls
+	unsigned int vertex_arrays;	//glBindVertexArray calls
+	unsigned int avoided;		//binds skipped because the object was already bound
+	unsigned int draws;			//glDraw* calls
+	unsigned int uniforms;		//glUniform* calls
+	unsigned int materials;		//materials bound, see MaterialRegistry
+
+	StateChanges() : programs(0), textures(0), vertex_arrays(0), avoided(0), draws(0),
+		uniforms(0), materials(0) {}
+	unsigned int total() const {return programs + textures + vertex_arrays;}
+};
+
+class GLState
+{
+public:
+	static void useProgram(unsigned int program);
+	//bind a texture to a texture unit
+	//PRE:
+	//	unit: index of the texture unit, starting from 0 (GL_TEXTURE0)
+	//	target: GL_TEXTURE_2D or GL_TEXTURE_BUFFER, binds to other targets are never skipped
+	static void bindTexture(unsigned int unit, unsigned int texture, 
+		GLenum target = GL_TEXTURE_2D);
+	static void bindVertexArray(unsigned int vao);
+
+	//a deleted texture is unbound from every unit, call this after deleting a texture
+	static void textureDeleted(unsigned int texture);
+	//forget every cached binding, the next bind of each object is always made
+	static void invalidate();
+
+	//count a draw call or a uniform update, call these after every glDraw* and glUniform*
+	static void drawCalled() {changes.draws++;}
+	static void uniformSet() {changes.uniforms++;}
+	//count a material bind, called by MaterialRegistry::bind()
+	static void materialBound() {changes.materials++;}
+
+	static const StateChanges& getChanges() {return changes;}
+	static void resetChanges() {changes = StateChanges();}
+
+private:
+	//bound objects, UNKNOWN if they might have been changed outside of this class
+	static const unsigned int UNKNOWN = ~0u;
+	static unsigned int program;
+	static unsigned int vertex_array;
+	static unsigned int active_unit;
+	//2D textures and buffer textures bound to each unit
+	static unsigned int textures[2][CACHED_TEXTURE_UNITS];
+	static StateChanges changes;
+};
+
+#endif
@@ -0,0 +1,35 @@
+#ifndef GL_TRACE_H
+#define GL_TRACE_H
+//this is a layer over the GL functions loaded by glad, it counts GL calls of every frame
+//install() replaces glad's function pointers with wrappers that count each call and then
+//call the driver. Binds, state changes and uniform updates are also checked against the
+//state they set last time; a call that sets the state it already has is reported as redundant.
+//Nothing is wrapped until install() is called, so the layer costs nothing when it is not used.
+//Only the functions the renderer calls are wrapped, other functions are not counted.
+//state set before install() is unknown, the first call of each state is never redundant
+#include <ostream>
+#include "glad/glad.h"
+
+class GLTrace
+{
+public:
+	//wrap glad's functions, call after glad is loaded. The wrappers stay for the rest of the
+	//program, calling install() again does nothing
+	static void install();
+	static bool isInstalled() {return installed;}
+
+	//start counting a new frame
+	static void beginFrame();
+	//write the calls of the current frame, busiest functions first
+	static void printFrame(std::ostream &out);
+
+	//calls of the current frame, and how many of them were redundant
+	static unsigned int getCalls();
+	static unsigned int getRedundant();
+
+private:
+	static bool installed;
+	static unsigned int frame;
+};
+
+#endif
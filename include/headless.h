@@ -0,0 +1,59 @@
+#ifndef HEADLESS_H
+#define HEADLESS_H
+//this is an OpenGL context without a window, for render farms and CI machines without a
+//display. The context is created by EGL, on Mesa its surfaceless platform is used so that
+//llvmpipe works without an X server. Frames are rendered into a framebuffer object with a
+//24 bits depth and 8 bits stencil buffer, like the default framebuffer of a window
+//
+//EGL is only used when the program is built with HEADLESS_EGL, see CMakeLists.txt
+#include <string>
+
+#include "glad/glad.h"
+
+//set global states expected by the scene, shared by windows, headless contexts and benchmarks
+//call this once after the context is current and glad is loaded
+void initGLState();
+
+class HeadlessContext
+{
+public:
+	//create the context, make it current and load glad
+	//PRE:
+	//	width, height: size of the off screen framebuffer
+	HeadlessContext(unsigned int width, unsigned int height);
+	~HeadlessContext();
+	HeadlessContext(const HeadlessContext&) = delete;
+	HeadlessContext& operator=(const HeadlessContext&) = delete;
+
+	//whether the context and the framebuffer are ready, nothing should be drawn otherwise
+	bool valid() const {return complete;}
+
+	//draw into the off screen framebuffer, call this before rendering a frame
+	void bind();
+
+	//write the color buffer into a binary PPM file
+	//POST:
+	//	return false if the file can't be written
+	bool saveImage(const std::string &path);
+
+	unsigned int getWidth() const {return width;}
+	unsigned int getHeight() const {return height;}
+
+private:
+	unsigned int width, height;
+	//EGL handles, kept as pointers so that EGL headers are not needed here
+	void *display;
+	void *surface;
+	void *context;
+	unsigned int fbo;
+	unsigned int color;			//color renderbuffer
+	unsigned int depth;			//depth and stencil renderbuffer
+	bool complete;
+
+	//create the EGL context and make it current
+	bool createContext();
+	//create the framebuffer object
+	bool createFramebuffer();
+};
+
+#endif
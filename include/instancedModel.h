@@ -0,0 +1,69 @@
+#ifndef INSTANCED_MODEL_H
+#define INSTANCED_MODEL_H
+//this is an instanced model class
+//every instance shares the meshes of one model and only has its own model matrix. All
+//instances are drawn with one draw call per mesh
+#include <vector>
+
+#include "glad/glad.h"
+#include "glm/glm.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+#include "model.h"
+#include "bounds.h"
+
+class InstancedModel
+{
+public:
+	//share the meshes of an uploaded model
+	//PRE:
+	//	model: its shader should be created with the INSTANCED define so that the model matrix
+	//		is read from the instance attribute, see General.vs
+	//NOTE: the model's VAOs are changed to read the instance buffer, don't render the model
+	//	with a non-instanced shader afterwards
+	InstancedModel(const Model &model);
+
+	//add an instance
+	//PRE:
+	//	transform: model matrix of the instance
+	//POST:
+	//	return index of the instance
+	unsigned int addInstance(const glm::mat4 &transform);
+	//add an instance given its position, rotation and scaling, see Model::calcModelView
+	unsigned int addInstance(glm::vec3 pos, float angle = 0.0f, glm::vec3 rotate = glm::vec3(1.0f),
+		glm::vec3 scale = glm::vec3(1.0f));
+
+	//change model matrix of an instance
+	//invalid index will result in nothing
+	void setInstance(unsigned int index, const glm::mat4 &transform);
+	//get model matrix of an instance, index should be valid
+	const glm::mat4& getInstance(unsigned int index) const {return transforms[index];}
+	//remove an instance, the last instance is moved to its index
+	//invalid index will result in nothing
+	void removeInstance(unsigned int index);
+	//number of instances
+	unsigned int size() const {return transforms.size();}
+
+	//bounds of all instances in world space
+	const Bounds& getWorldBounds();
+
+	//upload the instance buffer if any instance changed
+	void upload();
+	//upload the instance buffer if needed and draw all instances
+	void render();
+	//delete the instance buffer, instances can't be drawn afterwards
+	//call this function once before the instanced model is removed
+	void releaseBuffer();
+
+	//shared model, its model matrix is not used
+	Model model;
+
+private:
+	std::vector<glm::mat4> transforms;
+	unsigned int instance_vbo;	//model matrices of all instances
+	unsigned int capacity;		//number of instances the buffer can hold
+	bool dirty;					//whether transforms changed since the last upload
+	Bounds world_bounds;
+	bool bounds_dirty;			//whether world_bounds needs to be recalculated
+};
+
+#endif
@@ -11,6 +11,51 @@
 //include all other derived class
 #include "shader.h"
 
+const int LIGHTS_LIMIT = 10;	//maximum number of directional lights, same as General.fs
+
+/*
+	std140 layouts of the lights in General.fs's Lights uniform block
+	a vec3 is aligned to 16 bytes in std140, so every vec3 is followed by either a float member
+	or a padding float. Never reorder members without changing General.fs
+	point and spot lights are not in the block, they are binned into clusters, see 
+	lightClusters.h
+*/
+struct DirLightBlock {
+	glm::vec3 direction;	float pad0;
+	glm::vec3 ambient;		float pad1;
+	glm::vec3 diffuse;		float pad2;
+	glm::vec3 specular;		float pad3;
+};
+
+//a point or spot light in the cluster buffer, read by General.fs as 6 texels
+//a point light is a spot light whose cone covers every direction, a spot light is a point
+//light without attenuation. Ambient of spot lights doesn't depend on the cone, it is added up
+//into LightsBlock::ambient instead. A light doesn't reach fragments farther than its range,
+//the same range its clusters are found with
+struct LightRecord {
+	glm::vec3 position;		float outer_cutoff;		//cosine of the cutoff angle
+	glm::vec3 direction;	float inner_cutoff;
+	glm::vec3 ambient;		float constant;
+	glm::vec3 diffuse;		float linear;
+	glm::vec3 specular;		float quadra;
+	float range;			float pad[3];
+};
+
+//the whole Lights uniform block
+struct LightsBlock {
+	DirLightBlock dirLights[LIGHTS_LIMIT];
+	glm::vec3 ambient;		//ambient of every spot light
+	int dir_num;
+	int light_num;			//number of point and spot lights in the cluster buffer
+	int clusters[3];		//number of clusters along x, y and z
+	glm::vec2 tile;			//size of a cluster on the screen in pixels
+	glm::vec2 depth;		//slice of a view depth d is log(d) * depth.x + depth.y
+};
+
+static_assert(sizeof(DirLightBlock) == 64, "DirLightBlock doesn't match std140 layout");
+static_assert(sizeof(LightRecord) == 96, "LightRecord doesn't match 6 texels");
+static_assert(sizeof(LightsBlock) == 688, "LightsBlock doesn't match std140 layout");
+
 
 class Light
 {
@@ -31,26 +76,6 @@ public:
 	//a complete constructor
 	Light(glm::vec3 col, glm::vec3 dir, glm::vec3 pos, glm::vec3 amb, glm::vec3 diff, glm::vec3 spec) 
 		: color(col), direction(dir), position(pos), ambient(amb), diffuse(diff), specular(spec){}
-
-	//this function send light's spec into the shader
-	//Pre: 
-	//	shader: shader needs to be configured
-	//	name: light's name in the shader, the light should be the same type as 
-	//	the light class here
-	virtual void sendShader(Shader &shader, const std::string &name) const {
-		std::string dir(name);
-		std::string pos(name);
-		std::string amb(name);
-		std::string diff(name);
-		std::string spec(name);
-
-
-		shader.setVec3(dir.append(".direction"), direction);
-		shader.setVec3(pos.append(".position"), position);
-		shader.setVec3(amb.append(".ambient"), ambient * color);
-		shader.setVec3(diff.append(".diffuse"), diffuse * color);
-		shader.setVec3(spec.append(".specular"), specular * color);
-	}
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,118 @@
+#ifndef LIGHT_CLUSTERS_H
+#define LIGHT_CLUSTERS_H
+//this is the light grid of clustered forward shading
+//the view frustum is split into clusters, CLUSTERS_X * CLUSTERS_Y tiles on the screen and
+//CLUSTERS_Z slices along the view depth. Slices are exponential, every slice is the same
+//number of times deeper than the previous one. Every frame, point and spot lights are tested
+//against the bounds of every cluster in view space, and each cluster gets the list of lights
+//touching it. A fragment only shades the lights of its own cluster, see General.fs
+//
+//everything is uploaded into one RGBA32UI buffer texture, bound to LIGHTS_TEXTURE_UNIT:
+//	clusters: one texel per cluster, x is the offset of its first light index, y the count
+//	records: LightRecord of every light, 6 texels each, floats stored as their bits
+//	indices: light indices of every cluster, 4 per texel
+//one buffer texture is used so that material textures still fit in the 16 texture units a
+//GL 3.3 fragment shader is guaranteed to have
+#include <vector>
+#include <cstdint>
+#include <mutex>
+#include <condition_variable>
+#include <memory>
+
+#include "glad/glad.h"
+#include "glm/glm.hpp"
+#include "light.h"
+#include "pointLight.h"
+#include "spotLight.h"
+#include "threadPool.h"
+
+const unsigned int CLUSTERS_X = 16;
+const unsigned int CLUSTERS_Y = 9;
+const unsigned int CLUSTERS_Z = 24;
+const unsigned int CLUSTERS_NUM = CLUSTERS_X * CLUSTERS_Y * CLUSTERS_Z;
+//lights are binned on worker threads when there are at least this many
+const unsigned int PARALLEL_BINNING_LIGHTS = 64;
+
+class LightClusters
+{
+public:
+	LightClusters();
+	~LightClusters();
+	LightClusters(const LightClusters&) = delete;
+	LightClusters& operator=(const LightClusters&) = delete;
+
+	//calculate bounds of every cluster, call this function every time the projection changes
+	//PRE:
+	//	width, height: size of the framebuffer in pixels
+	void setProjection(const glm::mat4 &proj, float near, float far, unsigned int width,
+		unsigned int height);
+
+	//bin lights into clusters and upload the buffer
+	//nothing is done if neither the view nor any light changed since the last update
+	//PRE:
+	//	lights are stored contiguously, see slotMap.h
+	//POST:
+	//	return whether the buffer was uploaded
+	bool update(const glm::mat4 &view, const PointLight *points, unsigned int point_num,
+		const SpotLight *spots, unsigned int spot_num);
+
+	//write the grid of clusters into the Lights uniform block
+	void fillBlock(LightsBlock &block) const;
+
+	//number of light indices of all clusters in the last update
+	unsigned int getIndexCount() const {return index_count;}
+
+private:
+	unsigned int buffer;
+	unsigned int texture;
+	unsigned int capacity;				//size of the buffer in texels
+
+	glm::vec2 tile;
+	glm::vec2 depth;
+	//view space bounds of every cluster, as arrays so that 4 lights are tested at once
+	std::vector<float> min_x, min_y, min_z, max_x, max_y, max_z;
+	//bounding sphere of every cluster, used by spot lights
+	std::vector<float> center_x, center_y, center_z, radius;
+	std::vector<float> slice_near;		//view depth where every slice starts, CLUSTERS_Z + 1
+
+	//lights of the current frame in view space, spot lights are padded to a multiple of 4
+	//point lights are spheres, spot lights are cones without an end. Spot lights wider than
+	//a half space are binned as spheres of infinite radius
+	std::vector<float> point_x, point_y, point_z, point_r;
+	std::vector<float> spot_x, spot_y, spot_z, dir_x, dir_y, dir_z, spot_cos, spot_sin;
+	std::vector<unsigned int> point_ids, spot_ids;	//index of every light in records
+
+	//lights of the last update, so that an unchanged frame is not uploaded again
+	std::vector<LightRecord> records;
+	std::vector<LightRecord> next_records;
+	glm::mat4 last_view;
+	bool valid;
+
+	//lights binned by one thread
+	struct BinJob {
+		unsigned int first_slice, last_slice;
+		//point lights overlapping the current slice
+		std::vector<float> x, y, z, r2;
+		std::vector<unsigned int> ids;
+		std::vector<unsigned int> indices;	//light indices of its clusters
+	};
+	std::vector<BinJob> jobs;
+	unsigned int job_num;					//number of jobs used in the last update
+	uint32_t grid[CLUSTERS_NUM][2];			//offset into the job's indices and count
+	std::unique_ptr<ThreadPool> workers;	//created when there are enough lights
+	std::mutex jobs_mutex;
+	std::condition_variable jobs_done;
+	unsigned int jobs_left;
+
+	std::vector<uint32_t> texels;			//content of the buffer
+	unsigned int index_count;
+
+	//bin lights into the clusters of the job's slices
+	void bin(BinJob &job);
+	//split slices into jobs and bin them
+	void binAll();
+	//pack the grid, records and indices into texels and upload them
+	void upload();
+};
+
+#endif
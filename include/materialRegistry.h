@@ -0,0 +1,84 @@
+#ifndef MATERIAL_REGISTRY_H
+#define MATERIAL_REGISTRY_H
+//this is a registry of all materials used by meshes
+//a material is the colors and textures of a mesh. Meshes with the same colors and textures
+//share one material with a stable ID, so meshes of an imported file using the same material
+//are bound and sorted together. Colors of every material live in one uniform buffer and
+//textures are bound to fixed units, see shader.h. A material is bound by binding its range of
+//the buffer and its textures, no uniform is set
+//materials are reference counted like textures in TextureCache, a material is removed when
+//its last mesh releases it and its ID and buffer range are given to the next new material
+#include <vector>
+#include <string>
+#include <unordered_map>
+
+#include "glad/glad.h"
+#include "glm/glm.hpp"
+#include "mesh.h"
+#include "shader.h"
+#include "glState.h"
+
+//colors of a material in the uniform buffer
+//the layout should match MaterialBlock in General.fs
+struct MaterialBlock {
+	glm::vec3 ambient;
+	int amb_num;		//number of ambient textures, the color is used if there is none
+	glm::vec3 diffuse;
+	int diff_num;
+	glm::vec3 specular;
+	int spec_num;
+	float shininess;
+	float pad[3];
+};
+static_assert(sizeof(MaterialBlock) == 64, "MaterialBlock doesn't match std140 layout");
+
+class MaterialRegistry
+{
+public:
+	//get the ID of a material, it is added the first time these colors and textures are used
+	//PRE:
+	//	called on the rendering thread, texture IDs are loaded
+	//	textures: more than TEXTURE_LIMIT textures of one type are ignored, textures of other
+	//		types than ambient, diffuse and specular are ignored
+	//POST:
+	//	return an ID that stays valid until it is released, every call should be paired with a
+	//	release() call
+	static unsigned int get(const Material &material, const std::vector<Texture> &textures);
+
+	//release a material returned by get()
+	//the material is removed when it is no longer used
+	static void release(unsigned int ID);
+
+	//remove every material and delete the uniform buffer
+	//call this while the GL context is still alive, IDs returned before are no longer valid
+	static void clear();
+
+	//bind the colors and textures of a material
+	//PRE:
+	//	ID: returned by get()
+	static void bind(unsigned int ID);
+
+	//number of materials currently used
+	static unsigned int size() {return ids.size();}
+
+private:
+	struct Entry {
+		MaterialBlock block;
+		unsigned int textures[3 * TEXTURE_LIMIT];	//texture of each material unit, 0 for none
+	};
+	static std::vector<Entry> materials;
+	static std::vector<unsigned int> refs;		//number of get() calls not released yet
+	static std::vector<unsigned int> free_ids;	//IDs of removed materials, reused first
+	//IDs of materials keyed by the bytes of their entries
+	static std::unordered_map<std::string, unsigned int> ids;
+
+	static unsigned int ubo;
+	static unsigned int capacity;	//number of materials the buffer can hold
+	static unsigned int stride;		//bytes between two materials in the buffer
+	static unsigned int bound;		//material whose range is bound
+
+	//copy a material into the buffer, the buffer grows if it is full
+	static void upload(unsigned int ID);
+};
+
+#endif
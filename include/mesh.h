@@ -10,8 +10,14 @@
 #include <GLFW/glfw3.h>
 
 #include "shader.h"
+#include "bounds.h"
 #include "glm/glm.hpp"
 
+//first attribute location of the per instance model matrix, see General.vs
+const unsigned int INSTANCE_ATTRIB = 3;
+//material of a mesh that is not set up yet, see MaterialRegistry
+const unsigned int NO_MATERIAL = ~0u;
+
 struct Vertex {
 	glm::vec3 position;
 	glm::vec3 normal;
@@ -78,17 +84,46 @@ struct Material {
 
 class Mesh {
 public: 
-	//default constructor
-	Mesh() = default;
+	//default constructor, the mesh has no material until it is set up
+	Mesh() : material_id(NO_MATERIAL) {}
 	//complete constructor
+	//if upload is false, no GL function is called and setup() should be called later on the 
+	//rendering thread
 	Mesh(std::vector<Vertex> &vertex, std::vector<unsigned int> &index, std::vector<Texture> &tex, 
-		Material &mat): vertices(vertex), indices(index), textures(tex), material(mat){
-			setup();
+		Material &mat, bool upload = true): vertices(vertex), indices(index), textures(tex), 
+		material(mat), material_id(NO_MATERIAL){
+			calcBounds(vertices.data(), vertices.size());
+			if (upload)
+				setup();
 		}
 	//this function should be called every time you changed mesh's data
 	void setup();
-	//draw the mesh using provided shader
-	void render(Shader &shader);
+	//create GL buffers from vertex and index data that are not stored in this mesh
+	//vertices and indices of this mesh are left unchanged
+	void setup(const Vertex *vertex, unsigned int vertex_num, const unsigned int *index,
+		unsigned int index_num);
+	//calculate bounds of the mesh in model space from its vertices
+	void calcBounds(const Vertex *vertex, unsigned int vertex_num);
+	//draw the mesh with the shader in use, its material is bound first
+	void render();
+	//read per instance model matrices from a buffer, see InstancedModel
+	//this should be called after setup()
+	void setInstanceBuffer(unsigned int instance_vbo);
+	//draw several instances of the mesh with one draw call
+	//the shader in use should read the model matrix from the instance attribute
+	void renderInstanced(unsigned int instances);
+	//bind textures and colors of the material
+	void bindMaterial();
+	//draw the mesh with the material that is bound, see RenderQueue
+	//PRE:
+	//	instances: number of instances, 0 draws the mesh once without instancing
+	void draw(unsigned int instances = 0);
+	//find the material again after material or textures are changed
+	//this is called by setup(), on the rendering thread
+	void updateMaterial();
+	//release the material found by updateMaterial(), the mesh is drawn without a material
+	//afterwards
+	void releaseMaterial();
 
 	//overload << operator for debugging
 	friend std::ostream& operator<< (std::ostream&, const Mesh&);
@@ -98,10 +133,16 @@ public:
 	std::vector<unsigned int> indices;
 	std::vector<Texture> textures;
 	Material material;
+	//ID of the material and textures in MaterialRegistry, meshes with the same material and
+	//textures share it
+	unsigned int material_id;
+	//bounds in model space
+	Bounds bounds;
 
 private:
 	//rendering data
 	unsigned int VAO, VBO, EBO;
+	unsigned int index_count;	//number of indices uploaded
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,74 @@
+#ifndef MESH_CACHE_H
+#define MESH_CACHE_H
+//this file contains a baked binary format of imported models
+//a model file is imported with assimp once and its meshes are written into a baked file next
+//to it. Later runs map the baked file into memory and upload vertices and indices straight 
+//from the mapping, skipping assimp
+//
+//layout of a baked file (all offsets are from the start of the file, 4 bytes aligned):
+//	BakedHeader
+//	BakedMeshHeader * mesh_num
+//	texture references of every mesh: type length, type, path length, path
+//	vertex data of every mesh (interleaved Vertex)
+//	index data of every mesh
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "mesh.h"
+
+//a mesh inside an opened baked file
+//vertices and indices point into the mapped file and are valid until the file is closed
+struct BakedMesh {
+	const Vertex *vertices;
+	unsigned int vertex_num;
+	const unsigned int *indices;
+	unsigned int index_num;
+	Material material;
+	std::vector<Texture> textures;	//IDs are 0, only type and path are stored
+};
+
+class MeshCache
+{
+public:
+	//extension added to the model's path to get its baked file
+	static const std::string EXTENSION;
+
+	MeshCache() : data(NULL), size(0) {}
+	~MeshCache() {close();}
+
+	//map a baked file into memory
+	//PRE:
+	//	baked: path of the baked file
+	//	source: path of the model file it was baked from
+	//POST:
+	//	return false if the baked file doesn't exist, is broken, or is older than the source
+	bool open(const std::string &baked, const std::string &source);
+
+	//unmap the file, every pointer in meshes becomes invalid
+	void close();
+
+	//meshes in the opened file
+	const std::vector<BakedMesh>& getMeshes() const {return meshes;}
+
+	//write meshes into a baked file
+	//PRE:
+	//	meshes: meshes of the model, their vertices and indices should still be in memory
+	//POST:
+	//	return false if the file can not be written
+	static bool write(const std::string &baked, const std::string &source, 
+		const std::vector<Mesh> &meshes);
+
+private:
+	const char *data;	//mapped file
+	size_t size;		//size of the mapped file
+	std::vector<BakedMesh> meshes;
+
+	//read the source file's size and modification time
+	static bool sourceStamp(const std::string &source, uint64_t &size, int64_t &time);
+
+	MeshCache(const MeshCache&) = delete;
+	MeshCache& operator=(const MeshCache&) = delete;
+};
+
+#endif
@@ -16,6 +16,8 @@
 #include "glm/gtc/matrix_transform.hpp"
 #include "mesh.h"
 #include "shader.h"
+#include "textureCache.h"
+#include "meshCache.h"
 
 
 class Model 
@@ -23,14 +25,14 @@ class Model
 public:
 	//constructor provided with a path indicatin where the model is, process the model
 	//with assimp
-	Model(const std::string &path, Shader &shader) : shader(shader)
+	Model(const std::string &path, Shader &shader) : shader(&shader)
 	{
+		transparent = false;
+		deferred = false;
 		loadAiModel(path);
-		model = glm::mat4(1.0);
-		pos = glm::vec3(0.0);
-		rotate_angle = 0;
-		rotate = glm::vec3(1.0);
-		scale = glm::vec3(1.0);
+		uploaded = meshes.size();
+		transform = 0;
+		calcBounds();
 	}
 
 	//manually provide vertices' positions, normals, texture coordinates maeterial and texture file path
@@ -47,35 +49,67 @@ public:
 	//NOTE: the size of the positions, normals and coords arrays should have exactly the same size
 	Model(Shader &shader, std::vector<glm::vec3> &positions, std::vector<glm::vec3> &normals,
 		std::vector<unsigned int> &indices, std::vector<glm::vec2>  coords, Material &mat,
-		std::vector<std::string> &tex_path) : shader(shader)
+		std::vector<std::string> &tex_path) : shader(&shader)
 	{
+		transparent = false;
+		deferred = false;
 		loadManualModel(positions, normals, indices, coords, mat, tex_path);
-		model = glm::mat4(1.0);
-		pos = glm::vec3(0.0);
-		rotate_angle = 0;
-		rotate = glm::vec3(1.0);
-		scale = glm::vec3(1.0);
+		uploaded = meshes.size();
+		transform = 0;
+		calcBounds();
 	}
 
 
+	//create an empty model, meshes are added by importAsset() and uploadNext()
+	Model(Shader &shader) : shader(&shader)
+	{
+		transparent = false;
+		deferred = false;
+		uploaded = 0;
+		transform = 0;
+		calcBounds();
+	}
+
+	//import a model file with assimp without calling any GL function
+	//this can be called on a worker thread. Textures are only recorded, they are loaded
+	//when the meshes are uploaded
+	//POST:
+	//	return false if the file can not be imported
+	bool importAsset(const std::string &path);
+
+	//create GL buffers and load textures of the next mesh that is not uploaded yet
+	//this should be called on the rendering thread
+	//POST:
+	//	return the number of bytes uploaded, 0 if every mesh is already uploaded
+	unsigned int uploadNext();
+
+	//release all textures and materials used by this model's meshes
+	//call this function once before the model is removed
+	void releaseTextures();
+
 	//call this function to render the model with default shader
+	//the model matrix is read from the transform buffer, see Scene and transformBuffer.h
 	void render();
 	//render the model with a provided shader
 	void render(Shader&);
 
 	//directory of this model. All other textures should be in the same directory
 	std::string directory;
-	//shader used for this model
-	Shader shader;
+	//shader used for this model, shared with all models using the same program
+	//the shader should outlive this model, use ShaderRegistry to get one
+	Shader *shader;
 	
-	//calculate model view according to translation, rotation, and scaling
-	void calcModelView();
-	//initialize the position, rotation, and scaling vector
-	glm::mat4 model;
-	glm::vec3 pos, rotate, scale;
-	float rotate_angle;
+	//calculate bounds of all meshes, call this function every time meshes are changed
+	void calcBounds();
+	//index of the model's translation, rotation and scaling in the scene's TransformStore
+	//the model matrix and world bounds are kept there, see transformStore.h
+	unsigned int transform;
 
 	std::vector<Mesh> meshes;
+	//bounds of all meshes in model space
+	Bounds bounds;
+	//number of meshes that are uploaded, only these meshes are rendered
+	unsigned int uploaded;
 
 	//whether transparent
 	bool transparent;
@@ -85,26 +119,38 @@ public:
 	glm::vec3 outline_color;
 
 private:
-	//store loaded textures to optimize
-	std::vector<Texture> textures_loaded; 
-	//whether the model is outlined
+	//whether meshes are being imported without GL, see importAsset()
+	bool deferred;
 
 
 	//load the model using assimp
-	void loadAiModel(const std::string path);
+	//the baked file of the model is used instead if it is up to date, otherwise it is written
+	//after importing. See meshCache.h
+	//POST:
+	//	return false if the file can not be imported
+	bool loadAiModel(const std::string path);
+	//load meshes from the baked file of a model
+	//POST:
+	//	return false if the baked file doesn't exist or is out of date
+	bool loadBaked(const std::string &path);
 
 	//load the model with raw datas and textures
 	void loadManualModel(std::vector<glm::vec3> &positions, std::vector<glm::vec3> &normals,
 		std::vector<unsigned int> &indices, std::vector<glm::vec2> &coords, Material &mat, 
 		std::vector<std::string> &tex_path);
 	//recursively process each node and it's children
-	void processNode(aiNode *node, const aiScene *scene);
+	//PRE:
+	//	parent: transformation of the parent node relative to the model
+	void processNode(aiNode *node, const aiScene *scene, const glm::mat4 &parent);
 	//process a specific mesh to our defined mesh object
-	Mesh processMesh(aiMesh *mesh, const aiScene *scene);
+	//vertices are transformed by the node's transformation relative to the model, so that
+	//parts of a model keep their placement
+	Mesh processMesh(aiMesh *mesh, const aiScene *scene, const glm::mat4 &transform);
 	//used to load ai material texture
 	std::vector<Texture> loadMaterialTextures(aiMaterial *mat, aiTextureType type, 
 		const std::string name);
 	//both functions used to load textures
+	//textures are shared through TextureCache, each call acquires one reference
 	unsigned int loadTexture(const std::string &path, const std::string &directory);
 	unsigned int loadTexture(const std::string);
 
@@ -0,0 +1,51 @@
+#ifndef OIT_BUFFER_H
+#define OIT_BUFFER_H
+//this is the off screen buffer of weighted blended order independent transparency
+//(McGuire and Bavoil 2013)
+//transparent fragments are added up in any order into two targets:
+//	accum (RGBA16F): rgb is the sum of weighted premultiplied colors, a is the revealage,
+//		the product of (1 - alpha) of every fragment
+//	weight (R16F): sum of weighted alpha
+//both targets share one blend function so that only GL 3.3 is needed:
+//	color is added, alpha is multiplied by (1 - source alpha)
+//the average color is then blended onto the target framebuffer by a full screen pass
+#include "glad/glad.h"
+#include "shader.h"
+#include "glState.h"
+#include "renderTarget.h"
+
+class OITBuffer
+{
+public:
+	//PRE:
+	//	width, height: size of the target framebuffer
+	//	composite: shader resolving the buffer, Screen.vs and OITComposite.fs
+	OITBuffer(unsigned int width, unsigned int height, Shader &composite);
+	~OITBuffer();
+	OITBuffer(const OITBuffer&) = delete;
+	OITBuffer& operator=(const OITBuffer&) = delete;
+
+	//whether the framebuffer is complete, nothing should be drawn with it otherwise
+	bool valid() const {return complete;}
+
+	//clear the buffer and start drawing transparent fragments into it
+	//the depth buffer of the bound framebuffer is copied, so the target framebuffer should
+	//have a 24 bits depth and 8 bits stencil buffer of the same size
+	//depth writes are disabled until end()
+	void begin();
+	//blend the transparent fragments onto the framebuffer bound before begin()
+	//depth writes and blending are restored to the state set by initWindow()
+	void end();
+
+private:
+	unsigned int width, height;
+	unsigned int fbo;
+	unsigned int accum, weight;		//color textures
+	unsigned int depth;				//depth and stencil renderbuffer
+	unsigned int empty_vao;			//full screen pass has no vertex attribute
+	int target;						//framebuffer bound before begin()
+	bool complete;
+	Shader *composite;
+};
+
+#endif
@@ -31,11 +31,13 @@ public:
 			setAttenuation(distance);
 		}
 
-	//send all vectors to a specific shader with light's name
-	void sendShader(Shader &shader, const std::string &name) const override;
+	//write this light into its record of the cluster buffer
+	void fillRecord(LightRecord &record) const;
 	//set all coefficients from range
 	//you should call this function if you have changed range of this light
 	void setAttenuation(float distance);
+	//fragments farther than the range are not lit by this light
+	float getRange() const {return range;}
 
 private:
 	float constant;	//constant coefficient of attenuation	
@@ -0,0 +1,125 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+//this is a profiler of CPU scopes and GPU passes
+//a CPU scope is timed from its construction to its destruction:
+//	{
+//		ProfileScope scope("updateLights");
+//		...
+//	}
+//every thread writes its scopes into its own ring buffer without locking, the rendering thread
+//collects them once per frame in beginFrame(). A GPU pass is timed by a GL_TIME_ELAPSED query
+//around it, see GPUProfileScope. Queries are double buffered: the queries of a frame are read
+//two frames later, so the CPU doesn't wait for the GPU to finish the frame.
+//A capture is saved as Chrome trace events, which open in about:tracing or Perfetto
+//nothing is recorded while the profiler is disabled, scopes only check a flag. While it is
+//enabled the capture grows every frame, so frames are no longer free of allocations
+#include <atomic>
+#include <string>
+#include <vector>
+#include <ostream>
+#include "glad/glad.h"
+
+//number of scopes a thread can record between two beginFrame(), more scopes are dropped
+const unsigned int PROFILE_RING_SIZE = 4096;
+//number of GPU passes timed in a frame, more passes are not timed
+const unsigned int MAX_GPU_SCOPES = 16;
+
+//a finished scope, times are nanoseconds since the profiler was enabled
+struct ProfileEvent {
+	const char *name;		//a string literal, names are not copied
+	unsigned long long start;
+	unsigned long long duration;
+	unsigned int thread;	//index of the thread, see Profiler::GPU_THREAD
+};
+
+struct ProfileRing;
+
+class Profiler
+{
+public:
+	//thread index of GPU passes, CPU threads are numbered from 1
+	static const unsigned int GPU_THREAD = 0;
+
+	//start or stop recording, enabling drops the previous capture
+	static void setEnabled(bool enable);
+	static bool isEnabled() {return enabled.load(std::memory_order_relaxed);}
+
+	//call once per frame on the rendering thread, before any GPU scope of the frame
+	//scopes of every thread and GPU times of two frames ago are added to the capture
+	static void beginFrame();
+
+	//time a GPU pass, passes can't be nested
+	static void beginGPU(const char *name);
+	static void endGPU();
+
+	//add a finished scope of the calling thread, see ProfileScope
+	static void record(const char *name, unsigned long long start, unsigned long long end);
+	//nanoseconds since the profiler was enabled
+	static unsigned long long now();
+
+	//write the capture as Chrome trace events
+	//PRE:
+	//	the GL context is current, GPU times not read yet are waited for
+	//POST:
+	//	return false if the file can't be written
+	static bool save(const std::string &path);
+	//write the average milliseconds per frame of every scope name
+	static void printSummary(std::ostream &out);
+
+private:
+	static std::atomic<bool> enabled;
+	static std::vector<ProfileEvent> capture;
+	static unsigned int frames;			//number of beginFrame() calls since enabled
+
+	//GPU queries of the current and the previous frame
+	static GLuint queries[2][MAX_GPU_SCOPES];
+	static const char *gpu_names[2][MAX_GPU_SCOPES];
+	static unsigned long long gpu_starts[2][MAX_GPU_SCOPES];
+	static unsigned int gpu_counts[2];
+	static bool gpu_active;				//whether a query is running
+
+	//thread-local ring of the calling thread, created on its first scope
+	static ProfileRing& getRing();
+	//move finished scopes of every thread into the capture
+	static void collectScopes();
+	//read the queries of a frame into the capture
+	static void collectGPU(unsigned int set);
+};
+
+//time the enclosing block on the CPU
+class ProfileScope
+{
+public:
+	ProfileScope(const char *name) : name(name), active(Profiler::isEnabled()), start(0)
+	{
+		if (active)
+			start = Profiler::now();
+	}
+	~ProfileScope()
+	{
+		if (active)
+			Profiler::record(name, start, Profiler::now());
+	}
+
+private:
+	const char *name;
+	bool active;
+	unsigned long long start;
+
+	ProfileScope(const ProfileScope&) = delete;
+	ProfileScope& operator=(const ProfileScope&) = delete;
+};
+
+//time the GL commands of the enclosing block on the GPU
+class GPUProfileScope
+{
+public:
+	GPUProfileScope(const char *name) {Profiler::beginGPU(name);}
+	~GPUProfileScope() {Profiler::endGPU();}
+
+private:
+	GPUProfileScope(const GPUProfileScope&) = delete;
+	GPUProfileScope& operator=(const GPUProfileScope&) = delete;
+};
+
+#endif
@@ -0,0 +1,73 @@
+#ifndef RENDER_QUEUE_H
+#define RENDER_QUEUE_H
+//this is a render queue used to order draw calls
+//every visible mesh is pushed with a 64 bits sort key, the queue is radix sorted and drawn in
+//order so that meshes sharing a program and a material are drawn one after another. A material
+//is bound once for each batch of meshes using it, and redundant binds are skipped by GLState
+//
+//layout of a sort key, from the most significant bit:
+//	opaque and oit pass:	pass (2) | program (10) | material (24) | depth (28), front to back
+//	transparent pass:	pass (2) | depth (28), back to front | 0 (34)
+//transparent items at the same depth are drawn in the order they are pushed
+#include <vector>
+#include <cstdint>
+
+#include "glad/glad.h"
+#include "glm/glm.hpp"
+#include "mesh.h"
+#include "shader.h"
+
+//passes are drawn in this order
+enum RENDER_PASS {
+	OPAQUE_PASS = 0,
+	TRANSPARENT_PASS = 1,	//sorted back to front
+	OIT_PASS = 2			//order independent transparency, ordered like the opaque pass
+};
+
+//a draw call in the queue
+struct RenderItem {
+	Mesh *mesh;
+	Shader *shader;
+	int transform;				//index of the model matrix in the transform buffer
+								//-1 for instanced meshes
+	unsigned int instances;		//number of instances, 0 if not instanced
+};
+
+class RenderQueue
+{
+public:
+	//build a sort key
+	//PRE:
+	//	program: ID of the shader program
+	//	material: material ID of the mesh, see MaterialRegistry
+	//	depth: distance to the camera, from 0 (near plane) to 1 (far plane), clamped
+	static uint64_t makeKey(RENDER_PASS pass, unsigned int program, unsigned int material,
+		float depth);
+
+	//remove all items, memory is kept for the next frame
+	void clear() {items.clear(); entries.clear();}
+	//add a draw call
+	void push(uint64_t key, const RenderItem &item);
+	//sort items by their keys, items with equal keys keep their order
+	void sort();
+	//draw all items in order
+	void submit();
+	//draw items of one pass in order, the queue should be sorted
+	void submit(RENDER_PASS pass);
+	//number of items in the queue
+	unsigned int size() const {return items.size();}
+
+private:
+	struct Entry {
+		uint64_t key;
+		unsigned int index;		//index into items
+	};
+	std::vector<RenderItem> items;
+	std::vector<Entry> entries;
+	std::vector<Entry> scratch;	//second buffer of the radix sort
+
+	//draw entries in [begin, end)
+	void submit(unsigned int begin, unsigned int end);
+};
+
+#endif
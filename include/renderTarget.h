@@ -0,0 +1,16 @@
+#ifndef RENDER_TARGET_H
+#define RENDER_TARGET_H
+//textures that off screen framebuffers render into, see OITBuffer and GBuffer
+#include "glad/glad.h"
+#include "glState.h"
+
+//create a texture used as a color target
+//targets are sampled per pixel, so they are not filtered and not repeated
+//PRE:
+//	internal_format: a floating point format, format is its matching pixel format
+//POST:
+//	return the texture, it is left bound to unit 0
+unsigned int createColorTarget(GLint internal_format, GLenum format, unsigned int width,
+	unsigned int height);
+
+#endif
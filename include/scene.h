@@ -6,13 +6,27 @@
 #include <vector>
 #include <map>
 #include <unordered_map>
+#include <cstring>
+#include <memory>
+#include <atomic>
 #include "glad/glad.h"
 #include <GLFW/glfw3.h>
 
 #include "glm/glm.hpp"
 #include "glm/gtc/matrix_transform.hpp"
 #include "shader.h"
+#include "shaderRegistry.h"
 #include "model.h"
+#include "instancedModel.h"
+#include "renderQueue.h"
+#include "glState.h"
+#include "oitBuffer.h"
+#include "gBuffer.h"
+#include "transformBuffer.h"
+#include "transformStore.h"
+#include "sceneGraph.h"
+#include "slotMap.h"
+#include "lightClusters.h"
 #include "mesh.h"
 #include "light.h"
 #include "spotLight.h"
@@ -20,31 +34,90 @@
 #include "pointLight.h"
 #include "camera.h"
 #include "data.h"
+#include "allocCounter.h"
+#include "threadPool.h"
+#include "materialRegistry.h"
+#include "profiler.h"
 
 
+//how transparent models are blended
+enum TRANSPARENCY_MODE {
+	SORTED_TRANSPARENCY,	//models are drawn from farthest to closest
+	WEIGHTED_OIT			//weighted blended order independent transparency, see oitBuffer.h
+};
+
+//how opaque models are lit
+enum SHADING_MODE {
+	FORWARD_SHADING,		//every fragment is lit when it is drawn
+	DEFERRED_SHADING		//surfaces are drawn first, then every pixel is lit once, see gBuffer.h
+};
+
+//clipping planes of the projection
+const float NEAR_PLANE = 0.1f;
+const float FAR_PLANE = 100.0f;
+
 enum OBJECT_TYPE {
 	MODEL,
+	INSTANCED_MODEL,
 	SPOT_LIGHT,
 	DIR_LIGHT,
 	POINT_LIGHT,
 	INVALID
 };
 
+//loading status of a model added by addModelAsync
+enum LOAD_STATUS {
+	LOADING,		//file is being imported on a worker thread
+	UPLOADING,		//meshes are being uploaded to the GPU, partially rendered
+	LOADED,			//every mesh is rendered
+	LOAD_FAILED		//file can not be imported, the model stays empty
+};
+
+//handle of an object in the scene
+//an id of a removed object stays invalid even if its slot is reused, see slotMap.h
 struct SceneID {
-	unsigned int id;
+	unsigned int id;			//index of the object's slot
+	unsigned int generation;	//generation of the slot when the object was added
 	OBJECT_TYPE type;
 
-	SceneID(unsigned int id, OBJECT_TYPE type) : id(id), type(type){}
+	SceneID(SlotHandle handle, OBJECT_TYPE type) : id(handle.index), 
+		generation(handle.generation), type(type){}
+
+	SceneID(){id = 0; generation = 0; type = INVALID;}
 
-	SceneID(){id = 0; type = INVALID;}
+	SlotHandle handle() const {SlotHandle h = {id, generation}; return h;}
+	bool operator==(const SceneID &other) const
+	{
+		return id == other.id && generation == other.generation && type == other.type;
+	}
+};
+
+//statistics of the last rendered frame
+struct RenderStats {
+	unsigned int draws;			//number of models rendered
+	unsigned int culled;		//number of models outside of the view frustum, not rendered
+	unsigned int instances;		//number of instances drawn by instanced models
+	unsigned int transforms_rebuilt;	//world matrices rebuilt because the model or a parent moved
+	unsigned int state_changes;	//programs, textures and vertex arrays bound
+	unsigned int state_changes_avoided;	//binds skipped because the object was already bound
+	unsigned int draw_calls;	//GL draw calls, including full screen passes
+	unsigned int uniform_calls;	//uniforms set by programs, shared blocks are not counted
+	unsigned int material_binds;	//materials bound, once for each batch of meshes sharing one
+	unsigned long allocs;		//number of heap allocations made inside render()
+	bool lights_uploaded;		//whether the lights uniform buffer or clusters were re-uploaded
+	unsigned int light_indices;	//point and spot lights in all clusters, see lightClusters.h
+
+	RenderStats() : draws(0), culled(0), instances(0), transforms_rebuilt(0), state_changes(0), 
+		state_changes_avoided(0), draw_calls(0), uniform_calls(0), material_binds(0),
+		allocs(0), lights_uploaded(false), light_indices(0) {}
 };
 
 
 /*
 	NOTE: every object in this scene has its own unique id
 	NOTE: if you want to explicitly control all objects, call getter functions to get its pointer.
-		you can keep this pointer because this pointer will not change even if the hash map used to 
-		store the objects rehashed.
+		objects of one type are stored contiguously, so the pointer is only valid until an object
+		of the same type is added or removed. Keep the id and get the pointer again instead
 	NOTE: every scene may have only one camera
 */
 
@@ -59,13 +132,25 @@ public:
 		fragment_normal = curr_dir + "/../resources/shader/General.fs";
 		fragment_depth = curr_dir + "/../resources/shader/Depth.fs";
 		fragment_single_color = curr_dir + "/../resources/shader/SingleColor.fs";
+		vertex_screen = curr_dir + "/../resources/shader/Screen.vs";
+		fragment_oit_composite = curr_dir + "/../resources/shader/OITComposite.fs";
 
-		single_color_shader = Shader(vertex_normal, fragment_single_color);
+		single_color_shader = ShaderRegistry::get(vertex_normal, fragment_single_color);
 
 		camera = Camera(cam_pos); 
 		perspec = 1;
 		scrWidth = width;
 		scrHeight = height;
+
+		lights_ubo = createUniformBuffer(sizeof(LightsBlock), LIGHTS_BLOCK_BINDING);
+		lights_valid = false;
+		camera_ubo = createUniformBuffer(sizeof(CameraBlock), CAMERA_BLOCK_BINDING);
+		proj_fov = -1;
+		culling = true;
+		transparency = SORTED_TRANSPARENCY;
+		oit_draws = 0;
+		shading = FORWARD_SHADING;
+		import_budget = 4 * 1024 * 1024;
 	}
 
 	//manually set a object as transparent or not
@@ -73,6 +158,7 @@ public:
 	void setTransparent(SceneID model_id, bool trans);
 	
 	//set object's position.
+	//position, rotation and scaling are relative to the model's parent, see setModelParent
 	//PRE: 
 	//	model_id: scene id of the model need to be positioned. this should be valid, otherwise
 	//		nothing will be done
@@ -94,6 +180,14 @@ public:
 	//	scale: scaling vector
 	void setModelScale(SceneID model_id, glm::vec3 scale);
 
+	//attach a model to a parent model, the model follows the parent's transformation
+	//PRE:
+	//	model_id: scene id of the model, this should be valid, otherwise nothing will be done
+	//	parent_id: scene id of the parent model, SceneID() detaches the model from its parent
+	//		a model can't be attached to itself or one of its descendants
+	//NOTE: children of a removed model are attached to its parent
+	void setModelParent(SceneID model_id, SceneID parent_id);
+
 	//set the projection as perspective or ortho
 	//those two functions are not available currently
 	//void setPerspective() {perspec = true;}
@@ -101,6 +195,27 @@ public:
 	//check whether the current view is perspective
 	bool isPerspective() {return perspec;}
 
+	//enable or disable frustum culling, models are culled by default
+	void setCulling(bool enable) {culling = enable;}
+
+	//set how transparent models are blended, SORTED_TRANSPARENCY by default
+	//WEIGHTED_OIT doesn't depend on drawing order, so intersecting models are blended 
+	//correctly and transparent draws are batched like opaque ones. Colors of overlapping
+	//fragments are averaged by their weights instead of being layered exactly
+	//POST:
+	//	the mode is not changed if the off screen buffer can't be created
+	void setTransparency(TRANSPARENCY_MODE mode);
+	TRANSPARENCY_MODE getTransparency() {return transparency;}
+
+	//set how opaque models are lit, FORWARD_SHADING by default
+	//DEFERRED_SHADING lights every pixel once no matter how many models overlap it, it is
+	//faster when there are many lights and much overdraw, but uses more memory and bandwidth
+	//transparent models are always lit forward
+	//POST:
+	//	the mode is not changed if the off screen buffer can't be created
+	void setShading(SHADING_MODE mode);
+	SHADING_MODE getShading() {return shading;}
+
 	//render all models and lights in the scene
 	//this function will also update every models' view and projection matrices to fit the camera
 	void render();
@@ -116,6 +231,28 @@ public:
 	//	this ID should be kept in order to delete or edit the model
 	SceneID addModel(const std::string path);
 
+	//add a model into the scene without blocking
+	//the file is imported on a worker thread, then its meshes are uploaded a few at a time
+	//by render(). The model is rendered partially until every mesh is uploaded
+	//PRE:
+	//	path: path of the model file
+	//POST:
+	//	return an unique ID presenting this model, it can be used right away
+	SceneID addModelAsync(const std::string path);
+
+	//get loading status of a model
+	//PRE:
+	//	ID: id of the model
+	//	progress: if not NULL, set to the fraction of meshes uploaded (0 to 1)
+	//POST:
+	//	models added by other functions are always LOADED
+	//	LOAD_FAILED is returned if the id is invalid
+	LOAD_STATUS getModelStatus(SceneID ID, float *progress = NULL);
+
+	//set the maximum number of bytes of meshes uploaded per frame for models added by
+	//addModelAsync. At least one mesh is uploaded per frame
+	void setImportBudget(unsigned int bytes) {import_budget = bytes;}
+
 	//add a standard squre plane at the center of xy plane, this is a model
 	//PRE:
 	//	mat: material of the plane
@@ -125,6 +262,16 @@ public:
 
 	SceneID addCube(Material&, std::vector<std::string>&);
 
+	//add an instanced model, all of its instances are drawn with one draw call per mesh
+	//the model has no instance at first, add them through getInstancedModel()
+	//PRE:
+	//	same as addPlane, addCube and addModel
+	//POST:
+	//	return an unique ID presenting this instanced model
+	SceneID addInstancedPlane(Material&, std::vector<std::string>&);
+	SceneID addInstancedCube(Material&, std::vector<std::string>&);
+	SceneID addInstancedModel(const std::string path);
+
 	//this function is currently removed 
 	// //high light a model by outlining it, model is by default not high lighted
 	// //PRE:
@@ -198,6 +345,7 @@ public:
 	void removePointLight(SceneID ID);
 	void removeDirLight(SceneID ID);
 	void removeModel(SceneID ID);
+	void removeInstancedModel(SceneID ID);
 
 /*	---------------------------------------------------------------------------------------
 	Getter Functions
@@ -207,49 +355,123 @@ public:
 	//PRE:
 	// ID: returned id when adding the light into the scene
 	//POST:
-	// 	return a pointer points to the light
-	//	if the id is invalid, NULL will be returned
+	// 	return a pointer points to the light, valid until an object of the same type is added or
+	//	removed
+	//	if the id is invalid or the object has been removed, NULL will be returned
 	SpotLight*  getSpotLight(SceneID ID);
 	DirLight*   getDirLight(SceneID ID);
 	PointLight* getPointLight(SceneID ID);
 	Model* 		getModel(SceneID ID);
+	InstancedModel* getInstancedModel(SceneID ID);
 	Camera*		getCamera();
+	//get statistics of the last rendered frame
+	//a steady-state frame (no object added or removed) should report zero allocations
+	const RenderStats& getStats() {return stats;}
 
 
 
 private:
 
-	Shader single_color_shader;
+	Shader *single_color_shader;
 	//fragment and vertex shaders' path
 	std::string curr_dir;
 	std::string vertex_normal;
 	std::string fragment_normal;
 	std::string fragment_depth;
 	std::string fragment_single_color;
+	std::string vertex_screen;
+	std::string fragment_oit_composite;
 
 	unsigned int scrWidth;
 	unsigned int scrHeight;
 	bool perspec; //whether the scene is perspective
-	unsigned int count; //this is used for every object's id in the scene
 	Camera camera;
-	std::unordered_map<unsigned int, Model> models;
-	std::unordered_map<unsigned int, SpotLight> spotLights;
-	std::unordered_map<unsigned int, DirLight> dirLights;
-	std::unordered_map<unsigned int, PointLight> pointLights;
-
-	//set model's view and projection matrices
-	//model's position should be set in the setModelPos function
-	void setShader(Shader&, glm::mat4, glm::mat4, glm::mat4);
-
-	//send all lights in the scene to models' shaders
-	void sendLights(Model &model);
+	RenderStats stats;	//statistics of the last rendered frame
+	unsigned int lights_ubo;		//uniform buffer of the Lights block
+	LightsBlock lights_block;		//lights uploaded in the last update
+	bool lights_valid;				//whether lights_block has been uploaded
+	LightClusters clusters;			//point and spot lights binned for the current view
+	unsigned int camera_ubo;		//uniform buffer of the Camera block
+	glm::mat4 proj;					//cached projection matrix
+	float proj_fov;					//camera's fov when proj was calculated
+	bool culling;					//whether models outside of the frustum are skipped
+	Frustum frustum;				//view frustum of the current frame
+	RenderQueue queue;				//draws of the current frame
+	TransformStore model_transforms;	//translation, rotation and scaling of every model
+	std::vector<unsigned int> moved;	//transformations rebuilt in the current frame
+	SceneGraph graph;					//parents and world transformations of models
+	std::vector<glm::mat4> transforms;	//model matrices of the current frame, see queueModel
+	TransformBuffer transform_buffer;	//streams transforms to the GPU
+	TRANSPARENCY_MODE transparency;
+	std::unique_ptr<OITBuffer> oit;	//created when WEIGHTED_OIT is first used
+	unsigned int oit_draws;			//transparent draws queued in the current frame
+	//WEIGHTED_OIT variant of every shader used by transparent models
+	std::unordered_map<const Shader*, Shader*> oit_shaders;
+	SHADING_MODE shading;
+	std::unique_ptr<GBuffer> gbuffer;	//created when DEFERRED_SHADING is first used
+	//GBUFFER variant of every shader used by opaque models
+	std::unordered_map<const Shader*, Shader*> gbuffer_shaders;
+	glm::mat4 view;					//view matrix of the current frame
+
+	//a model being imported by addModelAsync
+	struct ModelImport {
+		SceneID id;					//scene id of the model
+		Model model;				//imported by the worker thread
+		std::atomic<int> status;	//LOADING until the worker finishes
+		bool moved;					//whether meshes are moved into the scene's model
+
+		ModelImport(SceneID id, Shader &shader) : id(id), model(shader), 
+			status(LOADING), moved(false) {}
+	};
+	std::vector<std::shared_ptr<ModelImport> > imports;
+	unsigned int import_budget;		//bytes uploaded per frame for imported models
+	SlotMap<Model> models;
+	SlotMap<InstancedModel> instancedModels;
+	SlotMap<SpotLight> spotLights;
+	SlotMap<DirLight> dirLights;
+	SlotMap<PointLight> pointLights;
+	//workers importing models, created on first use
+	//declared last so that workers are joined before anything else is destroyed
+	std::unique_ptr<ThreadPool> importer;
+
+	//pack all lights in the scene into the Lights uniform block
+	//the buffer is only uploaded if any light changed since the last frame
+	void updateLights();
+	//move finished imports into their models and upload meshes within the import budget
+	void updateImports();
+	//fill the Camera uniform block with the current view and projection
+	void updateCamera();
+	//whether a model with the given world bounds should be rendered in the current frame
+	//counts culled models
+	bool isVisible(const Bounds&);
+	//push every uploaded mesh of a model into the render queue
+	//the model matrix is appended to transforms, view and projection matrices are shared by
+	//all shaders through the Camera block
+	void queueModel(Model&);
+	void queueInstancedModel(InstancedModel&);
+	//push meshes of a model into the render queue
+	//PRE:
+	//	transform: index in transforms, -1 for instanced models
+	//	instances: 0 for models
+	void queueMeshes(Model &owner, int transform, unsigned int instances, float depth);
+	//get a variant of a shader with one more define, variants are kept in the given map
+	Shader* getVariant(std::unordered_map<const Shader*, Shader*> &variants, Shader *shader,
+		const char *define);
+	//view space depth of a point, 0 at the near plane and 1 at the far plane
+	float viewDepth(const glm::vec3&);
+	//add an instanced model sharing the meshes of a model
+	SceneID addInstancedModel(const Model&);
+	//give a model a transformation and an id, and add it into the scene
+	SceneID insertModel(Model&);
+	//create a uniform buffer of the given size and bind it to a binding point
+	unsigned int createUniformBuffer(unsigned int size, unsigned int binding);
 
 	//manually construct a model 
 	Model loadModel(Shader &shader, const float vertices[], const unsigned int indices[], 
 		const int vertex_size, const int index_size, Material &mat, std::vector<std::string> &tex_path);
 
-	//get projection matrix
-	glm::mat4 getProjMat();
+	//get projection matrix, it is only recalculated when camera's fov changed
+	const glm::mat4& getProjMat();
 
 };
 
@@ -0,0 +1,81 @@
+#ifndef SCENE_GRAPH_H
+#define SCENE_GRAPH_H
+//this is a hierarchy of transformations
+//every node has a transformation relative to its parent, its world matrix is the parent's
+//world matrix times its own. Nodes are stored in depth first order, so a parent is always
+//stored before its children and a subtree is a contiguous range. update() walks the nodes
+//once in order and only recalculates nodes that changed or whose ancestor changed
+//
+//nodes are identified by handles given by the caller, Scene uses the transformation index
+//of each model, see transformStore.h. Handles should be small, arrays are indexed by them
+#include <vector>
+#include <cstdint>
+
+#include "glm/glm.hpp"
+#include "bounds.h"
+
+class SceneGraph
+{
+public:
+	SceneGraph() : first_dirty(0) {}
+
+	//add a node without a parent, its transformation is the identity
+	//PRE:
+	//	handle: not used by any other node
+	void add(unsigned int handle);
+	//remove a node, its children are attached to its parent
+	void remove(unsigned int handle);
+
+	//attach a node and its subtree to a parent
+	//PRE:
+	//	parent: handle of the new parent, -1 to detach the node
+	//POST:
+	//	return false if parent is the node itself or one of its descendants, nothing is changed
+	bool setParent(unsigned int handle, int parent);
+	//POST:
+	//	return handle of the parent, -1 if the node has no parent
+	int getParent(unsigned int handle) const;
+
+	//set the transformation relative to the parent
+	void setLocal(unsigned int handle, const glm::mat4 &local);
+	//set bounds relative to the node, world bounds are transformed from them
+	void setBounds(unsigned int handle, const Bounds &bounds);
+
+	//recalculate world matrices and bounds of changed subtrees
+	//POST:
+	//	return number of nodes recalculated
+	unsigned int update();
+
+	//world matrix and bounds as of the last update()
+	const glm::mat4& getWorld(unsigned int handle) const {return world[positions[handle]];}
+	const Bounds& getWorldBounds(unsigned int handle) const
+	{
+		return world_bounds[positions[handle]];
+	}
+
+	//number of nodes
+	unsigned int size() const {return handles.size();}
+
+private:
+	//position of every handle in the arrays below, -1 if the handle is not used
+	std::vector<int> positions;
+	//nodes in depth first order
+	std::vector<unsigned int> handles;
+	std::vector<int> parents;				//position of the parent, -1 for roots
+	std::vector<unsigned int> subtree;		//number of nodes in the subtree, itself included
+	std::vector<uint8_t> dirty;				//whether the node changed since the last update
+	std::vector<glm::mat4> local;
+	std::vector<glm::mat4> world;
+	std::vector<Bounds> local_bounds;
+	std::vector<Bounds> world_bounds;
+	unsigned int first_dirty;				//no node before this position is dirty
+
+	void markDirty(unsigned int position);
+	//move the subtree at position so that it starts at target
+	//target is a position in the arrays without the subtree
+	void moveSubtree(unsigned int position, unsigned int target);
+	//add count to the subtree size of the node at position and all its ancestors
+	void growAncestors(int position, int count);
+};
+
+#endif
@@ -4,16 +4,55 @@
 #include "glad/glad.h"
 #include "glm/glm.hpp"
 #include "glm/gtc/type_ptr.hpp"
+#include "glState.h"
 
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+const int TEXTURE_LIMIT = 5;	//maximum number of textures of each type, same as General.fs
+
+//binding points of the uniform blocks shared by all programs
+//blocks are bound to these points right after a program is linked
+const unsigned int LIGHTS_BLOCK_BINDING = 0;
+const unsigned int CAMERA_BLOCK_BINDING = 1;
+//colors of the bound material, see materialRegistry.h
+const unsigned int MATERIAL_BLOCK_BINDING = 2;
+//first texture unit of each type of material textures, each type has TEXTURE_LIMIT units
+//samplers are set to these units right after a program is linked
+const unsigned int AMBIENT_TEXTURE_UNIT = 0;
+const unsigned int DIFFUSE_TEXTURE_UNIT = TEXTURE_LIMIT;
+const unsigned int SPECULAR_TEXTURE_UNIT = 2 * TEXTURE_LIMIT;
+//texture unit of the buffer texture holding model matrices, see transformBuffer.h
+//units below it are used by material textures
+const unsigned int TRANSFORMS_TEXTURE_UNIT = 15;
+static_assert(TEXTURE_LIMIT * 3 <= TRANSFORMS_TEXTURE_UNIT, "material textures overlap transforms");
+//texture unit of the buffer texture holding clustered lights, see lightClusters.h
+//a GL 3.3 fragment shader only has 16 units, material textures and lights have to fit in them
+const unsigned int LIGHTS_TEXTURE_UNIT = 16;
+static_assert(TEXTURE_LIMIT * 3 + 1 <= 16, "fragment shader uses too many texture units");
+
+//locations of the uniforms that are set for every draw
+//these are resolved once after the program is linked, so the rendering loop doesn't need to
+//build names or search the uniform table. Uniforms not used by the program are -1, and 
+//setting a -1 location does nothing
+struct UniformLocations {
+	int model;
+	int draw_id;	//index of the model matrix in the transform buffer
+};
 
 class Shader{
 
 public: 
 	//constructor that builds and reads the shader
-	Shader(const std::string &vertexPath, const std::string &fragmentPath);
+	//PRE:
+	//	defines: macros added right after the #version line of both shaders, each one is
+	//		"NAME" or "NAME VALUE"
+	Shader(const std::string &vertexPath, const std::string &fragmentPath,
+		const std::vector<std::string> &defines = std::vector<std::string>());
 
 	Shader() = default;
 
@@ -22,41 +61,104 @@ public:
 	//shader program ID
 	int ID;
 
+	//locations of common uniforms, filled after linking
+	UniformLocations locations;
+
 	//this function should be called before each rendering
+	//the program is not switched again if it is already in use
 	void use();
+	//stop using any program, call this before deleting programs
+	static void useNone();
+
+	//source files and defines this program is built from
+	const std::string& getVertexPath() const {return vertex;}
+	const std::string& getFragmentPath() const {return fragment;}
+	const std::vector<std::string>& getDefines() const {return defines;}
+
+	//bind a uniform block of this program to a binding point
+	//nothing is done if the program doesn't have this block
+	void bindUniformBlock(const std::string &name, unsigned int binding);
+
+	//get a uniform's location from the uniform table
+	//PRE:
+	//	name: uniform's name. Elements of arrays can be named as "name[i]"
+	//POST:
+	//	return -1 if the uniform is not an active uniform of this program
+	//	keep the returned location and use location setters in the rendering loop
+	int getUniform(const std::string &name) const {
+		auto search = uniforms.find(name);
+		if (search != uniforms.end())
+			return search->second;
+		return -1;
+	}
 
 	//set a bool uniform in the shader
 	void setBool(const std::string &name, bool value) const {
-		glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value);
+		setBool(getUniform(name), value);
 	}
 	//set a integer uniform in the shader
 	void setInt(const std::string &name, int value) const {
-		glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
+		setInt(getUniform(name), value);
 	}
 	//set a float uniform in the shader
 	void setFloat(const std::string &name, float value) const {
-		glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
+		setFloat(getUniform(name), value);
 	}
 	//set a mat4 unifrom in the shader
 	void setMat4(const std::string &name, glm::mat4 value) const {
-		glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, value_ptr(value));
+		setMat4(getUniform(name), value);
 	}
 	//set a vec3 uniform in the shader
 	void setVec3(const std::string &name, glm::vec3 value) const {
-		glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, value_ptr(value));
+		setVec3(getUniform(name), value);
 	}
 	//set a vec4 uniform in the shader
 	void setVec4(const std::string &name, glm::vec4 value) const {
-		glUniform4fv(glGetUniformLocation(ID, name.c_str()), 1, value_ptr(value));
+		setVec4(getUniform(name), value);
+	}
+
+	//setters using locations returned by getUniform or stored in locations
+	//every call is counted by GLState
+	void setBool(int location, bool value) const {
+		glUniform1i(location, (int)value);
+		GLState::uniformSet();
+	}
+	void setInt(int location, int value) const {
+		glUniform1i(location, value);
+		GLState::uniformSet();
+	}
+	void setFloat(int location, float value) const {
+		glUniform1f(location, value);
+		GLState::uniformSet();
+	}
+	void setMat4(int location, const glm::mat4 &value) const {
+		glUniformMatrix4fv(location, 1, GL_FALSE, value_ptr(value));
+		GLState::uniformSet();
+	}
+	void setVec3(int location, const glm::vec3 &value) const {
+		glUniform3fv(location, 1, value_ptr(value));
+		GLState::uniformSet();
+	}
+	void setVec4(int location, const glm::vec4 &value) const {
+		glUniform4fv(location, 1, value_ptr(value));
+		GLState::uniformSet();
 	}
 
 
 private:
 	std::string vertex, fragment;
+	std::vector<std::string> defines;
 	// check whether shader is compiled succesfully
 	void checkShaderSuccess(unsigned int shader, const std::string &type);
 	// check whether shader program is succesfully linked
 	void checkLinkSuccess(unsigned int ID);
+	//insert defines after the #version line of a shader source
+	void addDefines(std::string &code);
+	//enumerate all active uniforms of the linked program and fill the uniform table
+	void loadUniforms();
+
+	//all active uniforms' locations of this program
+	std::unordered_map<std::string, int> uniforms;
 
 };
 
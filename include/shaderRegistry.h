@@ -0,0 +1,47 @@
+#ifndef SHADER_REGISTRY_H
+#define SHADER_REGISTRY_H
+//this is a registry of all shader programs used in this program
+//identical programs (same source files and defines) are compiled only once and shared by 
+//every model using them
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+#include "glad/glad.h"
+#include "shader.h"
+
+class ShaderRegistry
+{
+public:
+	//get a shader program, the program is compiled and linked the first time it is requested
+	//PRE:
+	//	vertexPath: path of the vertex shader
+	//	fragmentPath: path of the fragment shader
+	//	defines: macros added to both shaders, see Shader's constructor
+	//POST:
+	//	return a pointer to the shared shader. This pointer will not change until clear()
+	//	is called, so it can be kept by models
+	static Shader* get(const std::string &vertexPath, const std::string &fragmentPath,
+		const std::vector<std::string> &defines = std::vector<std::string>());
+
+	//get a program built from the same sources as a shader with one more define
+	//POST:
+	//	return the shader itself if it already has the define
+	static Shader* variant(const Shader &shader, const std::string &define);
+
+	//number of programs compiled so far
+	static unsigned int size() {return programs.size();}
+
+	//delete all programs, every pointer returned by get() becomes invalid
+	static void clear();
+
+private:
+	//all shaders keyed by their source paths and defines
+	static std::unordered_map<std::string, Shader> programs;
+
+	//build the key of a program
+	static std::string makeKey(const std::string &vertexPath, const std::string &fragmentPath,
+		const std::vector<std::string> &defines);
+};
+
+#endif
@@ -0,0 +1,115 @@
+#ifndef SLOT_MAP_H
+#define SLOT_MAP_H
+//this is a generational slot map
+//values are kept in a dense array so that iterating them is contiguous. Every value is
+//reached through a slot, a handle stores the slot's index and generation. Removing a value
+//moves the last value into its place and increases the slot's generation, so a handle of a
+//removed value is detected as stale even after the slot is reused
+//
+//pointers to values are invalidated by insert() and remove()
+#include <vector>
+#include <utility>
+
+//handle of a value in a slot map
+struct SlotHandle {
+	unsigned int index;			//index of the slot
+	unsigned int generation;	//generation of the slot when the value was inserted
+};
+
+template <typename T>
+class SlotMap
+{
+public:
+	//add a value
+	//POST:
+	//	return handle of the value, slots of removed values are reused
+	SlotHandle insert(const T &value)
+	{
+		unsigned int index;
+		if (!free_slots.empty())
+		{
+			index = free_slots.back();
+			free_slots.pop_back();
+		}
+		else
+		{
+			index = slots.size();
+			//generations start at 1, a zero handle is never valid
+			slots.push_back(Slot(1));
+		}
+		slots[index].dense = values.size();
+		values.push_back(value);
+		owners.push_back(index);
+		SlotHandle handle = {index, slots[index].generation};
+		return handle;
+	}
+
+	//remove a value
+	//POST:
+	//	return false if the handle is invalid or stale
+	bool remove(SlotHandle handle)
+	{
+		if (!get(handle))
+			return false;
+		Slot &slot = slots[handle.index];
+		unsigned int last = values.size() - 1;
+		if (slot.dense != last)
+		{
+			values[slot.dense] = std::move(values[last]);
+			owners[slot.dense] = owners[last];
+			slots[owners[slot.dense]].dense = slot.dense;
+		}
+		values.pop_back();
+		owners.pop_back();
+		slot.dense = EMPTY;
+		slot.generation++;
+		free_slots.push_back(handle.index);
+		return true;
+	}
+
+	//POST:
+	//	return pointer to the value, NULL if the handle is invalid or stale
+	T* get(SlotHandle handle)
+	{
+		if (handle.index >= slots.size())
+			return NULL;
+		const Slot &slot = slots[handle.index];
+		if (slot.generation != handle.generation || slot.dense == EMPTY)
+			return NULL;
+		return &values[slot.dense];
+	}
+
+	//whether the handle refers to a slot whose value has been removed
+	bool stale(SlotHandle handle) const
+	{
+		return handle.index < slots.size() && slots[handle.index].generation != handle.generation;
+	}
+
+	//dense access, i is from 0 to size() - 1. The order changes when a value is removed
+	unsigned int size() const {return values.size();}
+	T& operator[](unsigned int i) {return values[i];}
+	const T& operator[](unsigned int i) const {return values[i];}
+	//handle of the value at dense position i
+	SlotHandle handle(unsigned int i) const
+	{
+		SlotHandle h = {owners[i], slots[owners[i]].generation};
+		return h;
+	}
+
+	typename std::vector<T>::iterator begin() {return values.begin();}
+	typename std::vector<T>::iterator end() {return values.end();}
+
+private:
+	static const unsigned int EMPTY = ~0u;
+	struct Slot {
+		unsigned int dense;			//index in values, EMPTY if the slot is free
+		unsigned int generation;
+		Slot(unsigned int generation) : dense(EMPTY), generation(generation) {}
+	};
+	std::vector<T> values;
+	std::vector<unsigned int> owners;	//slot of every value
+	std::vector<Slot> slots;
+	std::vector<unsigned int> free_slots;
+};
+
+#endif
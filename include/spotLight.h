@@ -23,8 +23,9 @@ public:
 		glm::vec3 diffuse, glm::vec3 specular, float inner, float outer) : Light(color, direction, 
 		position, ambient, diffuse, specular), inner_cutoff(inner), outer_cutoff(outer){} 
 
-	//send all vectors to a specific shader with light's name
-	void sendShader(Shader &shader, const std::string &name) const override;
+	//write this light into its record of the cluster buffer
+	//ambient is not written, it is added to the Lights uniform block by Scene
+	void fillRecord(LightRecord &record) const;
 };
 
 #endif
\ No newline at end of file
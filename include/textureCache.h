@@ -0,0 +1,76 @@
+#ifndef TEXTURE_CACHE_H
+#define TEXTURE_CACHE_H
+//this is a process-wide texture cache
+//every image file is decoded and uploaded only once, no matter how many models use it.
+//textures are reference counted, a texture is deleted when its last user releases it
+//
+//images are decoded by worker threads. A texture returned by acquire() holds a small 
+//placeholder until its image is decoded and uploaded by update() on the rendering thread
+#include <string>
+#include <unordered_map>
+
+#include "glad/glad.h"
+
+class TextureCache
+{
+public:
+	//get a texture from its file path, the file is loaded the first time it is requested
+	//PRE:
+	//	path: path of the image file. Different paths to the same file share one texture
+	//	channels: if not NULL, set to the number of channels of the image
+	//POST:
+	//	return the GL texture ID, every call should be paired with a release() call
+	static unsigned int acquire(const std::string &path, int *channels = NULL);
+
+	//release a texture returned by acquire()
+	//the texture is deleted when it is no longer used
+	static void release(unsigned int ID);
+
+	//upload images decoded by the worker threads into their textures
+	//this should be called once per frame on the rendering thread. Uploading stops once the
+	//upload budget is used up, but at least one image is uploaded on each call
+	static void update();
+
+	//set the maximum number of bytes uploaded by each update() call
+	static void setUploadBudget(unsigned int bytes) {upload_budget = bytes;}
+
+	//whether images are decoded by worker threads, this is true by default
+	//if false, acquire() decodes and uploads the image before it returns
+	static void setAsync(bool async) {decode_async = async;}
+
+	//statistics of the cache
+	static unsigned int hits() {return hit_count;}		//requests of already loaded textures
+	static unsigned int misses() {return miss_count;}	//requests that loaded a file
+	static unsigned int size() {return textures.size();}	//textures currently loaded
+	static unsigned int pending() {return pending_count;}	//textures still showing placeholder
+
+private:
+	struct Entry {
+		unsigned int ID;
+		int channels;
+		unsigned int refs;	//number of acquire() calls not released yet
+		bool pending;		//whether the image is not uploaded yet
+	};
+
+	//all textures keyed by canonical path
+	static std::unordered_map<std::string, Entry> textures;
+	//canonical path of every texture, used for releasing
+	static std::unordered_map<unsigned int, std::string> paths;
+	static unsigned int hit_count;
+	static unsigned int miss_count;
+	static unsigned int pending_count;
+	static unsigned int upload_budget;
+	static bool decode_async;
+
+	//get the absolute path without symbolic links, "." or ".."
+	static std::string canonicalPath(const std::string &path);
+	//decode an image and upload it into a new texture
+	static unsigned int load(const std::string &path, int &channels);
+	//create a new texture with placeholder and start decoding the image on a worker thread
+	static unsigned int loadAsync(const std::string &path, const std::string &key, int &channels);
+	//upload decoded image data into a texture
+	static void upload(unsigned int ID, const unsigned char *data, int width, int height, 
+		int channels);
+};
+
+#endif
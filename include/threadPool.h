@@ -0,0 +1,45 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+//this is a simple pool of worker threads
+//jobs are run in the order they are pushed. Jobs must NOT call any GL function, because the
+//GL context is only current on the rendering thread
+#include <vector>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+class ThreadPool
+{
+public:
+	//start the worker threads
+	//PRE:
+	//	threads: number of workers, 0 uses one worker per hardware thread except the 
+	//		rendering thread
+	ThreadPool(unsigned int threads = 0);
+
+	//stop all workers, jobs that are not started yet are dropped
+	~ThreadPool();
+
+	//add a job into the queue, one of the workers will run it
+	void push(std::function<void()> job);
+
+	//number of worker threads
+	unsigned int size() const {return workers.size();}
+
+private:
+	std::vector<std::thread> workers;
+	std::queue<std::function<void()> > jobs;
+	std::mutex jobs_mutex;
+	std::condition_variable condition;
+	bool stop;
+
+	//loop of every worker thread
+	void work();
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+};
+
+#endif
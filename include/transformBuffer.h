@@ -0,0 +1,49 @@
+#ifndef TRANSFORM_BUFFER_H
+#define TRANSFORM_BUFFER_H
+//this is a ring of buffers streaming model matrices to the GPU
+//model matrices of every model drawn in a frame are packed into one array and copied into
+//one buffer with a single map. Shaders read them through a buffer texture indexed by the
+//drawID uniform, see General.vs
+//
+//the ring has TRANSFORM_BUFFER_FRAMES buffers, each fenced after the frame using it. A buffer
+//is only written again once the GPU has passed its fence, so mapping never synchronizes
+//with draws still in flight
+#include <vector>
+
+#include "glad/glad.h"
+#include "glm/glm.hpp"
+#include "glState.h"
+#include "shader.h"
+
+//number of frames the CPU may run ahead of the GPU
+const unsigned int TRANSFORM_BUFFER_FRAMES = 3;
+
+class TransformBuffer
+{
+public:
+	TransformBuffer();
+	~TransformBuffer();
+	TransformBuffer(const TransformBuffer&) = delete;
+	TransformBuffer& operator=(const TransformBuffer&) = delete;
+
+	//copy the model matrices of this frame into the next buffer of the ring and bind it to
+	//TRANSFORMS_TEXTURE_UNIT
+	//POST:
+	//	the matrix at index i is read by draws with drawID i
+	void upload(const std::vector<glm::mat4> &transforms);
+	//fence the current buffer, call this after the last draw of the frame
+	void fence();
+
+	//number of uploads that waited for the GPU to finish with a buffer
+	unsigned int waits() const {return wait_count;}
+
+private:
+	unsigned int buffers[TRANSFORM_BUFFER_FRAMES];
+	unsigned int textures[TRANSFORM_BUFFER_FRAMES];	//buffer textures of the buffers
+	GLsync fences[TRANSFORM_BUFFER_FRAMES];
+	unsigned int capacity;		//number of matrices each buffer can hold
+	unsigned int current;		//buffer used by the current frame
+	unsigned int wait_count;
+};
+
+#endif
@@ -0,0 +1,65 @@
+#ifndef TRANSFORM_STORE_H
+#define TRANSFORM_STORE_H
+//this is a structure of arrays storage of model transformations
+//every component of position, rotation and scaling is kept in its own array, and a dirty bit
+//marks transformations changed since the last update(). update() rebuilds the model matrices
+//of changed transformations only, four at a time with SSE when available
+//
+//a model matrix is translate * rotate * scale, same as glm::translate, glm::rotate and
+//glm::scale applied in this order. In a scene it is relative to the model's parent, see
+//sceneGraph.h
+#include <vector>
+#include <cstdint>
+
+#include "glm/glm.hpp"
+
+class TransformStore
+{
+public:
+	TransformStore() : count(0) {}
+
+	//add an identity transformation
+	//POST:
+	//	return index of the transformation, indices of removed transformations are reused
+	unsigned int add();
+	//remove a transformation, its index may be returned by add() later
+	void remove(unsigned int index);
+
+	//setters mark the transformation as changed, index should be valid
+	void setPosition(unsigned int index, const glm::vec3 &pos);
+	//PRE:
+	//	angle: rotating angle in degrees
+	//	axis: rotating axis, it doesn't need to be normalized
+	void setRotation(unsigned int index, float angle, const glm::vec3 &axis);
+	void setScale(unsigned int index, const glm::vec3 &scale);
+
+	//rebuild model matrices of changed transformations
+	//POST:
+	//	indices of the rebuilt transformations are appended to changed
+	//	return number of transformations rebuilt
+	unsigned int update(std::vector<unsigned int> &changed);
+
+	//model matrix as of the last update()
+	const glm::mat4& getMatrix(unsigned int index) const {return matrices[index];}
+
+	//number of indices in use, including removed ones not reused yet
+	unsigned int size() const {return count;}
+
+private:
+	unsigned int count;
+	//components of every transformation, padded to a multiple of 4
+	std::vector<float> pos_x, pos_y, pos_z;
+	std::vector<float> axis_x, axis_y, axis_z;	//normalized rotating axis
+	std::vector<float> angle;						//rotating angle in radians
+	std::vector<float> scale_x, scale_y, scale_z;
+	std::vector<uint64_t> dirty;					//one bit per transformation
+	std::vector<glm::mat4> matrices;
+	std::vector<unsigned int> free_indices;
+
+	void markDirty(unsigned int index) {dirty[index >> 6] |= (uint64_t)1 << (index & 63);}
+	//rebuild num matrices starting at first
+	//4 matrices starting at a multiple of 4 are rebuilt together with SSE when available
+	void rebuild(unsigned int first, unsigned int num = 4);
+};
+
+#endif
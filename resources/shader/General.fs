@@ -2,20 +2,6 @@
 #define LIGHTS_LIMIT 10
 #define TEXTURE_LIMIT 5
 
-struct Material{
-	sampler2D tex_ambient[TEXTURE_LIMIT];
-	sampler2D tex_diffuse[TEXTURE_LIMIT];
-	sampler2D tex_specular[TEXTURE_LIMIT];
-	int amb_num;
-	int diff_num;
-	int spec_num;
-
-	vec3 ambient;
-	vec3 diffuse;
-	vec3 specular;
-	float shininess;
-};
-
 struct DirLight {
 	vec3 direction;
 	vec3 ambient;
@@ -23,43 +9,103 @@ struct DirLight {
 	vec3 specular;
 };
 
-struct PointLight {
-	vec3 position;
-	vec3 ambient;
-	vec3 diffuse;
-	vec3 specular;
-
-	float constant;
-	float linear;
-	float quadra;
-};
-
-struct SpotLight {
-	vec3 direction;
-	vec3 position;
-	vec3 ambient;
-	vec3 diffuse;
-	vec3 specular;
-
-	float inner_cutoff;	
-	float outer_cutoff;
-};
-
 in vec2 TexCoords;
+#ifdef DEFERRED_LIGHTING
+//lighting pass of deferred shading, drawn over the whole screen by Screen.vs
+//surfaces are read from the G-buffer written by the GBUFFER variant, see gBuffer.h
+uniform sampler2D gPosition;	//xyz: position, w: 1 where a surface is drawn
+uniform sampler2D gNormal;		//xyz: normal, w: shininess
+uniform sampler2D gAmbient;
+uniform sampler2D gAlbedo;		//diffuse color
+uniform sampler2D gSpecular;
+vec3 FragPos;
+vec3 Normal;
+#else
 in vec3 FragPos;
 in vec3 Normal;
+#endif
+
+#ifdef WEIGHTED_OIT
+//weighted blended order independent transparency, see oitBuffer.h
+//rgb: weighted premultiplied color, a: alpha, multiplied into the revealage by blending
+layout (location = 0) out vec4 Accum;
+//sum of weighted alpha
+layout (location = 1) out float Weight;
+#elif defined(GBUFFER)
+//G-buffer pass of deferred shading, nothing is lit, see gBuffer.h
+layout (location = 0) out vec4 GPosition;
+layout (location = 1) out vec4 GNormal;
+layout (location = 2) out vec4 GAmbient;
+layout (location = 3) out vec4 GAlbedo;
+layout (location = 4) out vec4 GSpecular;
+#else
 out vec4 FragColor;
+#endif
+
+//directional lights and the cluster grid, shared by every program through one uniform buffer
+//the layout should match LightsBlock in light.h
+layout (std140) uniform Lights {
+	DirLight dirLights[LIGHTS_LIMIT]; 
+	vec3 SPOT_AMBIENT;		//ambient of every spot light
+	int DIR_LIGHTS_NUM;
+	int LIGHTS_NUM;			//number of point and spot lights
+	int CLUSTERS_X;
+	int CLUSTERS_Y;
+	int CLUSTERS_Z;
+	vec2 CLUSTER_TILE;		//size of a cluster on the screen in pixels
+	vec2 CLUSTER_DEPTH;		//slice of a view depth d is log(d) * x + y
+};
 
-uniform int DIR_LIGHTS_NUM;
-uniform int POINT_LIGHTS_NUM;
-uniform int SPOT_LIGHTS_NUM;
+//point and spot lights binned into clusters, see lightClusters.h
+//clusters, then 6 texels of every light, then light indices of every cluster
+uniform usamplerBuffer clusters;
 
-uniform DirLight dirLights[LIGHTS_LIMIT]; 
-uniform PointLight pointLights[LIGHTS_LIMIT];
-uniform SpotLight spotLights[LIGHTS_LIMIT];
+//shared by every program, filled once per frame
+//the layout should match CameraBlock in camera.h
+layout (std140) uniform Camera {
+	mat4 view;
+	mat4 proj;
+	vec3 viewPos;
+};
 
-uniform Material material;
-uniform vec3 viewPos;
+#ifndef DEFERRED_LIGHTING
+//colors of the material being drawn, one range of a buffer holding every material
+//the layout should match MaterialBlock in materialRegistry.h
+layout (std140) uniform MaterialBlock {
+	vec3 ambient;
+	int amb_num;		//number of textures of each type, the color is used if there is none
+	vec3 diffuse;
+	int diff_num;
+	vec3 specular;
+	int spec_num;
+	float shininess;
+} material;
+
+//textures of the material, each type is bound to its own units, see shader.h
+uniform sampler2D tex_ambient[TEXTURE_LIMIT];
+uniform sampler2D tex_diffuse[TEXTURE_LIMIT];
+uniform sampler2D tex_specular[TEXTURE_LIMIT];
+#endif
+
+//colors of the surface being shaded, read once by loadSurface()
+vec4 surfaceAmbient;
+vec4 surfaceDiffuse;
+vec4 surfaceSpecular;
+float surfaceShininess;
+
+//sum of the first num textures in a sampler array
+//sampler arrays can only be indexed with constant expressions in GLSL 330, so this is unrolled
+#define sampleTextures(samplers, num) ( \
+	((num) > 0 ? texture(samplers[0], TexCoords) : vec4(0)) + \
+	((num) > 1 ? texture(samplers[1], TexCoords) : vec4(0)) + \
+	((num) > 2 ? texture(samplers[2], TexCoords) : vec4(0)) + \
+	((num) > 3 ? texture(samplers[3], TexCoords) : vec4(0)) + \
+	((num) > 4 ? texture(samplers[4], TexCoords) : vec4(0)))
+
+//read the surface of this fragment from the material or the G-buffer
+//POST:
+//	return false if there is no surface, only in the lighting pass
+bool loadSurface();
 
 //functions to calculate ambient, diffuse and specular
 vec4 calcAmbient(vec3 light_amb);
@@ -68,32 +114,83 @@ vec4 calcSpecular(vec3 light_spec, vec3 normal, vec3 lightDir, vec3 viewDir);
 
 //functions to calculate different light type
 vec4 processDirLights(vec3 normal, vec3 viewDir);
-vec4 processPointLights(vec3 normal, vec3 viewDir);
-vec4 processSpotLights(vec3 normal, vec3 viewDir);
+//point and spot lights of the fragment's cluster
+vec4 processClusteredLights(vec3 normal, vec3 viewDir);
 
 void main()
 {
+	if (!loadSurface())
+		discard;
+#ifdef GBUFFER
+	GPosition = vec4(FragPos, 1.0);
+	GNormal = vec4(normalize(Normal), surfaceShininess);
+	GAmbient = surfaceAmbient;
+	GAlbedo = surfaceDiffuse;
+	GSpecular = surfaceSpecular;
+#else
 	//light properties
 	vec3 norm = normalize(Normal);
 	vec3 viewDir = normalize(viewPos - FragPos);
-	vec4 result;
+	vec4 result = vec4(0);
 
 	result += processDirLights(norm, viewDir);
-	result += processPointLights(norm, viewDir);
-	result += processSpotLights(norm, viewDir);
+	result += processClusteredLights(norm, viewDir);
 	if(result == vec4(0))	//no light in this shader, add ambient light manually
 	{
 		result += calcAmbient(vec3(0.2));
 	}
 
+#ifdef WEIGHTED_OIT
+	//alpha of every light is added up, it is clamped by the blending of a normal target
+	float alpha = clamp(result.a, 0.0, 1.0);
+	//closer fragments weigh more, gl_FragCoord.z is not linear so it is sharpened first
+	float weight = clamp(pow(min(1.0, alpha * 10.0) + 0.01, 3.0) * 1e8 * 
+		pow(1.0 - gl_FragCoord.z * 0.9, 3.0), 1e-2, 3e3);
+	Accum = vec4(result.rgb * alpha * weight, alpha);
+	Weight = alpha * weight;
+#else
 	FragColor = result;
+#endif
+#endif
+}
 
+bool loadSurface()
+{
+#ifdef DEFERRED_LIGHTING
+	ivec2 pixel = ivec2(gl_FragCoord.xy);
+	vec4 position = texelFetch(gPosition, pixel, 0);
+	if (position.w == 0.0)
+		return false;
+	vec4 normal = texelFetch(gNormal, pixel, 0);
+	FragPos = position.xyz;
+	Normal = normal.xyz;
+	surfaceShininess = normal.w;
+	surfaceAmbient = texelFetch(gAmbient, pixel, 0);
+	surfaceDiffuse = texelFetch(gAlbedo, pixel, 0);
+	surfaceSpecular = texelFetch(gSpecular, pixel, 0);
+#else
+	//materials without a map use their own color
+	if (material.amb_num == 0)
+		surfaceAmbient = vec4(material.ambient, 1.0);
+	else
+		surfaceAmbient = sampleTextures(tex_ambient, material.amb_num);
+	if (material.diff_num == 0)
+		surfaceDiffuse = vec4(material.diffuse, 1.0);
+	else
+		surfaceDiffuse = sampleTextures(tex_diffuse, material.diff_num);
+	if (material.spec_num == 0)
+		surfaceSpecular = vec4(material.specular, 1.0);
+	else
+		surfaceSpecular = sampleTextures(tex_specular, material.spec_num);
+	surfaceShininess = material.shininess;
+#endif
+	return true;
 }
 
 vec4 processDirLights(vec3 normal, vec3 viewDir)
 {
 	vec3 lightDir;
-	vec4 ambient, diffuse, specular;
+	vec4 ambient = vec4(0), diffuse = vec4(0), specular = vec4(0);
 	for (int i = 0; i < DIR_LIGHTS_NUM; i ++)
 	{	
 		lightDir = normalize(-dirLights[i].direction);
@@ -104,42 +201,48 @@ vec4 processDirLights(vec3 normal, vec3 viewDir)
 	return (ambient + diffuse + specular);
 }
 
-vec4 processPointLights(vec3 normal, vec3 viewDir)
+vec4 processClusteredLights(vec3 normal, vec3 viewDir)
 {
-	vec3 lightDir;
-	vec4 ambient, diffuse, specular;
-	for (int i = 0; i < POINT_LIGHTS_NUM; i ++)
+	vec4 ambient = vec4(0), diffuse = vec4(0), specular = vec4(0);
+	if (SPOT_AMBIENT != vec3(0))
+		ambient += calcAmbient(SPOT_AMBIENT);
+
+	//cluster of the fragment
+	float depth = -(view * vec4(FragPos, 1.0)).z;
+	int slice = clamp(int(log(depth) * CLUSTER_DEPTH.x + CLUSTER_DEPTH.y), 0, CLUSTERS_Z - 1);
+	ivec2 tile = clamp(ivec2(gl_FragCoord.xy / CLUSTER_TILE), ivec2(0), 
+		ivec2(CLUSTERS_X - 1, CLUSTERS_Y - 1));
+	int cluster = (slice * CLUSTERS_Y + tile.y) * CLUSTERS_X + tile.x;
+	uvec2 range = texelFetch(clusters, cluster).xy;
+
+	int record_base = CLUSTERS_X * CLUSTERS_Y * CLUSTERS_Z;
+	int index_base = record_base + LIGHTS_NUM * 6;
+	for (uint i = 0u; i < range.y; i ++)
 	{
-		lightDir = normalize(pointLights[i].position - FragPos);
-		//calculate attenuation
-		float dis = length(pointLights[i].position - FragPos);
-		float attenuation = 1.0 / (pointLights[i].constant + pointLights[i].linear*dis + 
-			pointLights[i].quadra*(dis*dis));
-
-		ambient += calcAmbient(pointLights[i].ambient) * attenuation; 
-		diffuse += calcDiffuse(pointLights[i].diffuse, normal, lightDir) * attenuation;
-		specular += calcSpecular(pointLights[i].specular, normal, lightDir, viewDir) * attenuation;
-	}
-	
-	return (ambient + diffuse + specular);
-}
-
-vec4 processSpotLights(vec3 normal, vec3 viewDir)
-{
-	vec3 lightDir;
-	vec4 ambient, diffuse, specular;
-	for (int i = 0; i < SPOT_LIGHTS_NUM; i ++)
-	{
-		lightDir = normalize(spotLights[i].position - FragPos);
+		uint k = range.x + i;
+		int record = record_base + int(texelFetch(clusters, index_base + int(k / 4u))[k % 4u]) * 6;
+		//see LightRecord in light.h
+		vec4 position = uintBitsToFloat(texelFetch(clusters, record));
+		//lights don't reach past their range, so neighbouring clusters shade the same
+		float dis = length(position.xyz - FragPos);
+		if (dis > uintBitsToFloat(texelFetch(clusters, record + 5).x))
+			continue;
+		vec4 direction = uintBitsToFloat(texelFetch(clusters, record + 1));
+		vec4 amb = uintBitsToFloat(texelFetch(clusters, record + 2));
+		vec4 diff = uintBitsToFloat(texelFetch(clusters, record + 3));
+		vec4 spec = uintBitsToFloat(texelFetch(clusters, record + 4));
+
+		vec3 lightDir = normalize(position.xyz - FragPos);
+		//calculate attenuation, spot lights are not attenuated
+		float attenuation = 1.0 / (amb.w + diff.w * dis + spec.w * (dis * dis));
 		//calculate theta, angle between light direction and frag direction
-		float theta = dot(lightDir, normalize(-spotLights[i].direction));
-		float epsilon = spotLights[i].inner_cutoff - spotLights[i].outer_cutoff;
-		float intensity = clamp((theta - spotLights[i].outer_cutoff) / epsilon, 0.0, 1.0);
-
-		//do light calculation
-		ambient += calcAmbient(spotLights[i].ambient);
-		diffuse += calcDiffuse(spotLights[i].diffuse, normal, lightDir) * intensity;
-		specular += calcSpecular(spotLights[i].specular, normal, lightDir, viewDir) * intensity;
+		//point lights are always inside their cone
+		float theta = dot(lightDir, normalize(-direction.xyz));
+		float intensity = clamp((theta - position.w) / (direction.w - position.w), 0.0, 1.0);
+
+		ambient += calcAmbient(amb.rgb) * attenuation;
+		diffuse += calcDiffuse(diff.rgb, normal, lightDir) * intensity * attenuation;
+		specular += calcSpecular(spec.rgb, normal, lightDir, viewDir) * intensity * attenuation;
 	}
 
 	return (ambient + diffuse + specular);
@@ -147,14 +250,7 @@ vec4 processSpotLights(vec3 normal, vec3 viewDir)
 
 vec4 calcAmbient(vec3 light_amb)
 {
-	vec4 tex; 
-	if (material.amb_num == 0)	//no ambient map, use material's own ambient color
-		tex = vec4(material.ambient, 1.0);
-	else
-	{
-		for (int i = 0; i < material.amb_num; i ++)
-			tex += texture(material.tex_ambient[i], TexCoords);
-	}
+	vec4 tex = surfaceAmbient;
 	
 	//discard fragment with too low alpha value
 	// if (tex.w < 0.1)
@@ -165,17 +261,9 @@ vec4 calcAmbient(vec3 light_amb)
 
 vec4 calcDiffuse(vec3 light_diff, vec3 normal, vec3 lightDir)
 {
-	vec4 tex;
+	vec4 tex = surfaceDiffuse;
 	float diff = max(dot(normal, lightDir), 0.0);
 
-	if (material.diff_num == 0) //no diffuse map, use material's own diffuse color
-		tex = vec4(material.diffuse, 1.0);
-	else 
-	{
-		for (int i = 0; i < material.diff_num; i ++)
-			tex += texture(material.tex_diffuse[i], TexCoords);
-	}
-
 	//discard fragment with too low alpha value
 	// if (tex.w < 0.1)
 	// 	discard;
@@ -185,17 +273,9 @@ vec4 calcDiffuse(vec3 light_diff, vec3 normal, vec3 lightDir)
 
 vec4 calcSpecular(vec3 light_spec, vec3 normal, vec3 lightDir, vec3 viewDir)
 {
-	vec4 tex;
+	vec4 tex = surfaceSpecular;
 	vec3 reflectDir = reflect(-lightDir, normal);
-	float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
-
-	if (material.spec_num == 0) //no specular map, use material's own specular color
-		tex = vec4(material.specular, 1.0);
-	else 
-	{
-		for (int i = 0; i < material.spec_num; i ++)
-			tex += texture(material.tex_specular[i], TexCoords);
-	}
+	float spec = pow(max(dot(viewDir, reflectDir), 0.0), surfaceShininess);
 
 	//discard fragment with too low alpha value
 	// if (tex.w < 0.1)
@@ -4,9 +4,23 @@ layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTexCoord;
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 proj;
+#ifdef INSTANCED
+//model matrix of each instance, takes locations 3 to 6
+layout (location = 3) in mat4 aInstanceModel;
+#else
+//model matrices of every model drawn in this frame, one matrix is 4 texels (columns)
+//filled once per frame, see transformBuffer.h
+uniform samplerBuffer transforms;
+//index of the model matrix of the current draw
+uniform int drawID;
+#endif
+
+//shared by every program, filled once per frame
+layout (std140) uniform Camera {
+	mat4 view;
+	mat4 proj;
+	vec3 viewPos;
+};
 
 out vec3 Normal;
 out vec3 FragPos;
@@ -14,6 +28,13 @@ out vec2 TexCoords;
 
 void main()
 {
+#ifdef INSTANCED
+	mat4 model = aInstanceModel;
+#else
+	int base = drawID * 4;
+	mat4 model = mat4(texelFetch(transforms, base), texelFetch(transforms, base + 1),
+		texelFetch(transforms, base + 2), texelFetch(transforms, base + 3));
+#endif
 	gl_Position = proj * view * model * vec4(aPos, 1.0);
 	FragPos = vec3(model * vec4(aPos, 1.0));
 	Normal = mat3(transpose(inverse(model))) * aNormal;
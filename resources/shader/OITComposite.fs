@@ -0,0 +1,21 @@
+#version 330 core
+//resolve weighted blended transparency onto the opaque image, see oitBuffer.h
+
+in vec2 TexCoords;
+out vec4 FragColor;
+
+uniform sampler2D accum;	//rgb: sum of weighted color, a: revealage
+uniform sampler2D weight;	//r: sum of weighted alpha
+
+void main()
+{
+	vec4 acc = texture(accum, TexCoords);
+	float revealage = acc.a;
+	//nothing transparent covers this pixel
+	if (revealage >= 1.0)
+		discard;
+
+	vec3 color = acc.rgb / max(texture(weight, TexCoords).r, 1e-5);
+	//blended with SRC_ALPHA, ONE_MINUS_SRC_ALPHA
+	FragColor = vec4(color, 1.0 - revealage);
+}
@@ -0,0 +1,37 @@
+#include "../include/allocCounter.h"
+//replacement of global operator new/delete used to count heap allocations
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+static std::atomic<unsigned long> alloc_count(0);
+
+unsigned long getAllocCount()
+{
+	return alloc_count.load(std::memory_order_relaxed);
+}
+
+void* operator new(std::size_t size)
+{
+	alloc_count.fetch_add(1, std::memory_order_relaxed);
+	//malloc(0) may return NULL, new should always return a unique pointer
+	void *ptr = std::malloc(size ? size : 1);
+	if (!ptr)
+		throw std::bad_alloc();
+	return ptr;
+}
+
+void* operator new[](std::size_t size)
+{
+	return operator new(size);
+}
+
+void operator delete(void *ptr) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept
+{
+	std::free(ptr);
+}
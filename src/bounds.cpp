@@ -0,0 +1,112 @@
+#include "../include/bounds.h"
+#include <cmath>
+#include <algorithm>
+
+using namespace glm;
+
+void Bounds::calc(const vec3 *positions, unsigned int num, unsigned int stride)
+{
+	*this = Bounds();
+	if (!num)
+		return;
+
+	const char *ptr = (const char*)positions;
+	min = max = *positions;
+	for (unsigned int i = 1; i < num; i ++)
+	{
+		const vec3 &p = *(const vec3*)(ptr + i * stride);
+		min = glm::min(min, p);
+		max = glm::max(max, p);
+	}
+
+	//the sphere is centered in the box, it is usually tighter than half of the diagonal
+	center = (min + max) * 0.5f;
+	float radius2 = 0;
+	for (unsigned int i = 0; i < num; i ++)
+	{
+		vec3 d = *(const vec3*)(ptr + i * stride) - center;
+		radius2 = std::max(radius2, dot(d, d));
+	}
+	radius = std::sqrt(radius2);
+}
+
+void Bounds::merge(const Bounds &other)
+{
+	if (other.empty())
+		return;
+	if (empty())
+	{
+		*this = other;
+		return;
+	}
+
+	min = glm::min(min, other.min);
+	max = glm::max(max, other.max);
+	//both spheres are inside the sphere centered in the merged box
+	vec3 merged = (min + max) * 0.5f;
+	radius = std::max(length(center - merged) + radius, length(other.center - merged) + other.radius);
+	center = merged;
+}
+
+Bounds Bounds::transform(const mat4 &mat) const
+{
+	if (empty())
+		return *this;
+
+	//the transformed box is centered at the transformed center, each of its half extents
+	//is the sum of the absolute projections of the old half extents
+	vec3 half = (max - min) * 0.5f;
+	vec3 box_center = vec3(mat * vec4((min + max) * 0.5f, 1.0f));
+	vec3 extent(0.0f);
+	for (int i = 0; i < 3; i ++)
+		extent += abs(vec3(mat[i])) * half[i];
+
+	Bounds result;
+	result.min = box_center - extent;
+	result.max = box_center + extent;
+	result.center = vec3(mat * vec4(center, 1.0f));
+	//scaling may not be uniform, use the longest axis
+	float scale = std::max(length(vec3(mat[0])), std::max(length(vec3(mat[1])),
+		length(vec3(mat[2]))));
+	result.radius = radius * scale;
+	return result;
+}
+
+Frustum::Frustum(const mat4 &m)
+{
+	//rows of the matrix, glm matrices are column major
+	vec4 row[4];
+	for (int i = 0; i < 4; i ++)
+		row[i] = vec4(m[0][i], m[1][i], m[2][i], m[3][i]);
+
+	planes[0] = row[3] + row[0];	//left
+	planes[1] = row[3] - row[0];	//right
+	planes[2] = row[3] + row[1];	//bottom
+	planes[3] = row[3] - row[1];	//top
+	planes[4] = row[3] + row[2];	//near
+	planes[5] = row[3] - row[2];	//far
+	//normalize so that distances to the planes can be compared with the radius
+	for (int i = 0; i < 6; i ++)
+		planes[i] /= length(vec3(planes[i]));
+}
+
+bool Frustum::intersects(const Bounds &bounds) const
+{
+	if (bounds.empty())
+		return false;
+
+	for (int i = 0; i < 6; i ++)
+	{
+		const vec4 &plane = planes[i];
+		vec3 normal = vec3(plane);
+		if (dot(normal, bounds.center) + plane.w < -bounds.radius)
+			return false;
+		//corner of the box furthest along the normal
+		vec3 corner(normal.x > 0 ? bounds.max.x : bounds.min.x,
+					normal.y > 0 ? bounds.max.y : bounds.min.y,
+					normal.z > 0 ? bounds.max.z : bounds.min.z);
+		if (dot(normal, corner) + plane.w < 0)
+			return false;
+	}
+	return true;
+}
@@ -92,6 +92,13 @@ float Camera::getFOV(){
 	return _fov;
 }
 
+void Camera::setPose(glm::vec3 position, float yaw, float pitch){
+	Position = position;
+	_yaw = yaw;
+	_pitch = pitch;
+	updateCamera();
+}
+
 void Camera::setSpeed(float speed){
 	_speed = speed;
 }
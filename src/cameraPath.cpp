@@ -0,0 +1,115 @@
+#include "../include/cameraPath.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+
+using namespace std;
+using namespace glm;
+
+//Catmull-Rom spline through p1 and p2, t is from 0 (p1) to 1 (p2)
+template <typename T>
+static T catmullRom(const T &p0, const T &p1, const T &p2, const T &p3, float t)
+{
+	float t2 = t * t;
+	float t3 = t2 * t;
+	return 0.5f * ((2.0f * p1) + (p2 - p0) * t + (2.0f * p0 - 5.0f * p1 + 4.0f * p2 - p3) * t2 +
+		(3.0f * p1 - p0 - 3.0f * p2 + p3) * t3);
+}
+
+bool CameraPath::addKey(float time, const vec3 &position, float yaw, float pitch)
+{
+	if (!keys.empty() && time < keys.back().time)
+	{
+		cout << "ERROR::CAMERA_PATH::KEY_OUT_OF_ORDER: " << time << endl;
+		return false;
+	}
+	Key key = {time, position, yaw, pitch};
+	keys.push_back(key);
+	return true;
+}
+
+bool CameraPath::addKey(float time, Camera &camera)
+{
+	return addKey(time, camera.Position, camera.getYaw(), camera.getPitch());
+}
+
+bool CameraPath::load(const string &path)
+{
+	ifstream file(path.c_str());
+	if (!file)
+	{
+		cout << "ERROR::CAMERA_PATH::FILE_NOT_SUCCESFULLY_READ: " << path << endl;
+		return false;
+	}
+	string line;
+	unsigned int line_num = 0;
+	while (getline(file, line))
+	{
+		line_num++;
+		istringstream words(line);
+		string word;
+		if (!(words >> word) || word[0] == '#')
+			continue;
+		float time, yaw, pitch;
+		vec3 position;
+		if (word != "key" || !(words >> time >> position.x >> position.y >> position.z >> yaw
+			>> pitch))
+		{
+			cout << "ERROR::CAMERA_PATH::INVALID_KEY: " << path << ":" << line_num << endl;
+			return false;
+		}
+		if (!addKey(time, position, yaw, pitch))
+			return false;
+	}
+	return true;
+}
+
+bool CameraPath::save(const string &path) const
+{
+	ofstream file(path.c_str());
+	if (!file)
+	{
+		cout << "ERROR::CAMERA_PATH::FILE_NOT_SUCCESFULLY_WRITTEN: " << path << endl;
+		return false;
+	}
+	file << "#key time x y z yaw pitch" << endl;
+	for (unsigned int i = 0; i < keys.size(); i ++)
+	{
+		const Key &key = keys[i];
+		file << "key " << key.time << " " << key.position.x << " " << key.position.y << " "
+			<< key.position.z << " " << key.yaw << " " << key.pitch << endl;
+	}
+	return file.good();
+}
+
+void CameraPath::apply(float time, Camera &camera) const
+{
+	if (keys.empty())
+		return;
+	if (time <= keys.front().time || keys.size() == 1)
+	{
+		camera.setPose(keys.front().position, keys.front().yaw, keys.front().pitch);
+		return;
+	}
+	if (time >= keys.back().time)
+	{
+		camera.setPose(keys.back().position, keys.back().yaw, keys.back().pitch);
+		return;
+	}
+
+	//first key after the time, there is always one before it
+	unsigned int next = 1;
+	while (keys[next].time <= time)
+		next ++;
+	const Key &k1 = keys[next - 1];
+	const Key &k2 = keys[next];
+	//the first and the last keys are repeated at the ends of the path
+	const Key &k0 = next > 1 ? keys[next - 2] : k1;
+	const Key &k3 = next + 1 < keys.size() ? keys[next + 1] : k2;
+	float t = (time - k1.time) / (k2.time - k1.time);
+
+	vec3 position = catmullRom(k0.position, k1.position, k2.position, k3.position, t);
+	vec2 angles = catmullRom(vec2(k0.yaw, k0.pitch), vec2(k1.yaw, k1.pitch),
+		vec2(k2.yaw, k2.pitch), vec2(k3.yaw, k3.pitch), t);
+	camera.setPose(position, angles.x, angles.y);
+}
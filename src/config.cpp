@@ -36,15 +36,25 @@ GLFWwindow* initWindow(unsigned int SCR_WIDTH, unsigned int SCR_HEIGHT, const st
 		return NULL;
 	}
 
-	glEnable(GL_DEPTH_TEST);
-	glEnable(GL_STENCIL_TEST);
-	glEnable(GL_BLEND);
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-	glDepthFunc(GL_LESS);
+	initGLState();
 
 	return window;
 }
 
+HeadlessContext* initHeadless(unsigned int SCR_WIDTH, unsigned int SCR_HEIGHT){
+	HeadlessContext *context = new HeadlessContext(SCR_WIDTH, SCR_HEIGHT);
+	if (!context->valid())
+	{
+		cout << "Failed to create headless context" << endl;
+		delete context;
+		return NULL;
+	}
+
+	initGLState();
+
+	return context;
+}
+
 //process user input
 void processInput(GLFWwindow *window){
 	if(glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
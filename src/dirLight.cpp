@@ -3,16 +3,10 @@
 using namespace glm;
 using namespace std;
 
-void DirLight::sendShader(Shader &shader, const string &name) const
+void DirLight::fillBlock(DirLightBlock &block) const
 {
-
-	string dir(name);
-	string amb(name);
-	string diff(name);
-	string spec(name);
-
-	shader.setVec3(dir.append(".direction"), direction);
-	shader.setVec3(amb.append(".ambient"), ambient * color);
-	shader.setVec3(diff.append(".diffuse"), diffuse * color);
-	shader.setVec3(spec.append(".specular"), specular * color);
+	block.direction = direction;
+	block.ambient = ambient * color;
+	block.diffuse = diffuse * color;
+	block.specular = specular * color;
 }
\ No newline at end of file
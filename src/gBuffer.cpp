@@ -0,0 +1,92 @@
+#include "../include/gBuffer.h"
+#include <iostream>
+
+using namespace std;
+
+GBuffer::GBuffer(unsigned int width, unsigned int height, Shader &lighting) :
+	width(width), height(height), target(0), lighting(&lighting)
+{
+	//positions need more precision than 16 bits floats far from the origin
+	targets[0] = createColorTarget(GL_RGBA32F, GL_RGBA, width, height);
+	for (unsigned int i = 1; i < G_BUFFER_TARGETS; i ++)
+		targets[i] = createColorTarget(GL_RGBA16F, GL_RGBA, width, height);
+
+	glGenRenderbuffers(1, &depth);
+	glBindRenderbuffer(GL_RENDERBUFFER, depth);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	GLint previous;
+	glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previous);
+	glGenFramebuffers(1, &fbo);
+	glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+	GLenum buffers[G_BUFFER_TARGETS];
+	for (unsigned int i = 0; i < G_BUFFER_TARGETS; i ++)
+	{
+		buffers[i] = GL_COLOR_ATTACHMENT0 + i;
+		glFramebufferTexture2D(GL_FRAMEBUFFER, buffers[i], GL_TEXTURE_2D, targets[i], 0);
+	}
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depth);
+	glDrawBuffers(G_BUFFER_TARGETS, buffers);
+	complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+	if (!complete)
+		cout << "ERROR::FRAMEBUFFER::G_BUFFER_NOT_COMPLETE" << endl;
+	glBindFramebuffer(GL_FRAMEBUFFER, previous);
+
+	glGenVertexArrays(1, &empty_vao);
+
+	//texture units are fixed, set them once
+	lighting.use();
+	lighting.setInt("gPosition", 0);
+	lighting.setInt("gNormal", 1);
+	lighting.setInt("gAmbient", 2);
+	lighting.setInt("gAlbedo", 3);
+	lighting.setInt("gSpecular", 4);
+}
+
+GBuffer::~GBuffer()
+{
+	glDeleteFramebuffers(1, &fbo);
+	glDeleteTextures(G_BUFFER_TARGETS, targets);
+	for (unsigned int i = 0; i < G_BUFFER_TARGETS; i ++)
+		GLState::textureDeleted(targets[i]);
+	glDeleteRenderbuffers(1, &depth);
+	glDeleteVertexArrays(1, &empty_vao);
+}
+
+void GBuffer::begin()
+{
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &target);
+	glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+	//w of the position is 0 where nothing is drawn
+	const float clear_color[] = {0.0f, 0.0f, 0.0f, 0.0f};
+	for (unsigned int i = 0; i < G_BUFFER_TARGETS; i ++)
+		glClearBufferfv(GL_COLOR, i, clear_color);
+	glClear(GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+	glDisable(GL_BLEND);
+}
+
+void GBuffer::end()
+{
+	//models drawn after the lighting pass are hidden by opaque ones
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, target);
+	glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+	glBindFramebuffer(GL_FRAMEBUFFER, target);
+
+	//lit colors are blended like opaque models of the forward path
+	glEnable(GL_BLEND);
+	//the full screen triangle is not hidden by anything and doesn't change the depth
+	glDisable(GL_DEPTH_TEST);
+	glDepthMask(GL_FALSE);
+
+	lighting->use();
+	for (unsigned int i = 0; i < G_BUFFER_TARGETS; i ++)
+		GLState::bindTexture(i, targets[i]);
+	GLState::bindVertexArray(empty_vao);
+	glDrawArrays(GL_TRIANGLES, 0, 3);
+	GLState::drawCalled();
+
+	glEnable(GL_DEPTH_TEST);
+	glDepthMask(GL_TRUE);
+}
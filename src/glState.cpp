@@ -0,0 +1,83 @@
+#include "../include/glState.h"
+
+unsigned int GLState::program = GLState::UNKNOWN;
+unsigned int GLState::vertex_array = GLState::UNKNOWN;
+unsigned int GLState::active_unit = GLState::UNKNOWN;
+unsigned int GLState::textures[2][CACHED_TEXTURE_UNITS] = {
+	{UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN,
+	UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN},
+	{UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN,
+	UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN}};
+StateChanges GLState::changes;
+
+void GLState::useProgram(unsigned int _program)
+{
+	if (program == _program)
+	{
+		changes.avoided++;
+		return;
+	}
+	glUseProgram(_program);
+	program = _program;
+	changes.programs++;
+}
+
+void GLState::bindTexture(unsigned int unit, unsigned int texture, GLenum target)
+{
+	//cached bindings of this target, NULL if it is not cached
+	unsigned int *bound = NULL;
+	if (unit < CACHED_TEXTURE_UNITS && target == GL_TEXTURE_2D)
+		bound = &textures[0][unit];
+	else if (unit < CACHED_TEXTURE_UNITS && target == GL_TEXTURE_BUFFER)
+		bound = &textures[1][unit];
+
+	if (bound && *bound == texture)
+	{
+		changes.avoided++;
+		return;
+	}
+	if (active_unit != unit)
+	{
+		glActiveTexture(GL_TEXTURE0 + unit);
+		active_unit = unit;
+	}
+	glBindTexture(target, texture);
+	if (bound)
+		*bound = texture;
+	changes.textures++;
+}
+
+void GLState::bindVertexArray(unsigned int vao)
+{
+	if (vertex_array == vao)
+	{
+		changes.avoided++;
+		return;
+	}
+	glBindVertexArray(vao);
+	vertex_array = vao;
+	changes.vertex_arrays++;
+}
+
+void GLState::textureDeleted(unsigned int texture)
+{
+	for (unsigned int i = 0; i < CACHED_TEXTURE_UNITS; i ++)
+	{
+		if (textures[0][i] == texture)
+			textures[0][i] = 0;
+		if (textures[1][i] == texture)
+			textures[1][i] = 0;
+	}
+}
+
+void GLState::invalidate()
+{
+	program = UNKNOWN;
+	vertex_array = UNKNOWN;
+	active_unit = UNKNOWN;
+	for (unsigned int i = 0; i < CACHED_TEXTURE_UNITS; i ++)
+	{
+		textures[0][i] = UNKNOWN;
+		textures[1][i] = UNKNOWN;
+	}
+}
@@ -0,0 +1,649 @@
+#include "../include/glTrace.h"
+#include <cstring>
+#include <vector>
+#include <algorithm>
+#include <unordered_map>
+
+using namespace std;
+
+//functions that are only counted: return type, name without gl, parameters, arguments
+#define COUNTED_FUNCTIONS(X) \
+	X(void, BufferData, (GLenum target, GLsizeiptr size, const void *data, GLenum usage), \
+		(target, size, data, usage)) \
+	X(void, BufferSubData, (GLenum target, GLintptr offset, GLsizeiptr size, const void *data), \
+		(target, offset, size, data)) \
+	X(void *, MapBufferRange, (GLenum target, GLintptr offset, GLsizeiptr length, \
+		GLbitfield access), (target, offset, length, access)) \
+	X(GLboolean, UnmapBuffer, (GLenum target), (target)) \
+	X(void, TexImage2D, (GLenum target, GLint level, GLint internalformat, GLsizei width, \
+		GLsizei height, GLint border, GLenum format, GLenum type, const void *pixels), \
+		(target, level, internalformat, width, height, border, format, type, pixels)) \
+	X(void, TexParameteri, (GLenum target, GLenum pname, GLint param), (target, pname, param)) \
+	X(void, TexBuffer, (GLenum target, GLenum internalformat, GLuint buffer), \
+		(target, internalformat, buffer)) \
+	X(void, GenerateMipmap, (GLenum target), (target)) \
+	X(void, PixelStorei, (GLenum pname, GLint param), (pname, param)) \
+	X(void, GenTextures, (GLsizei n, GLuint *textures), (n, textures)) \
+	X(void, GenBuffers, (GLsizei n, GLuint *buffers), (n, buffers)) \
+	X(void, GenVertexArrays, (GLsizei n, GLuint *arrays), (n, arrays)) \
+	X(void, GenFramebuffers, (GLsizei n, GLuint *framebuffers), (n, framebuffers)) \
+	X(void, GenRenderbuffers, (GLsizei n, GLuint *renderbuffers), (n, renderbuffers)) \
+	X(void, GenQueries, (GLsizei n, GLuint *ids), (n, ids)) \
+	X(void, DeleteQueries, (GLsizei n, const GLuint *ids), (n, ids)) \
+	X(void, VertexAttribPointer, (GLuint index, GLint size, GLenum type, GLboolean normalized, \
+		GLsizei stride, const void *pointer), (index, size, type, normalized, stride, pointer)) \
+	X(void, EnableVertexAttribArray, (GLuint index), (index)) \
+	X(void, VertexAttribDivisor, (GLuint index, GLuint divisor), (index, divisor)) \
+	X(void, RenderbufferStorage, (GLenum target, GLenum internalformat, GLsizei width, \
+		GLsizei height), (target, internalformat, width, height)) \
+	X(void, FramebufferRenderbuffer, (GLenum target, GLenum attachment, \
+		GLenum renderbuffertarget, GLuint renderbuffer), \
+		(target, attachment, renderbuffertarget, renderbuffer)) \
+	X(void, FramebufferTexture2D, (GLenum target, GLenum attachment, GLenum textarget, \
+		GLuint texture, GLint level), (target, attachment, textarget, texture, level)) \
+	X(GLenum, CheckFramebufferStatus, (GLenum target), (target)) \
+	X(void, DrawBuffers, (GLsizei n, const GLenum *bufs), (n, bufs)) \
+	X(void, BlitFramebuffer, (GLint srcX0, GLint srcY0, GLint srcX1, GLint srcY1, GLint dstX0, \
+		GLint dstY0, GLint dstX1, GLint dstY1, GLbitfield mask, GLenum filter), \
+		(srcX0, srcY0, srcX1, srcY1, dstX0, dstY0, dstX1, dstY1, mask, filter)) \
+	X(void, ReadPixels, (GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, \
+		GLenum type, void *pixels), (x, y, width, height, format, type, pixels)) \
+	X(void, Clear, (GLbitfield mask), (mask)) \
+	X(void, ClearBufferfv, (GLenum buffer, GLint drawbuffer, const GLfloat *value), \
+		(buffer, drawbuffer, value)) \
+	X(void, DrawArrays, (GLenum mode, GLint first, GLsizei count), (mode, first, count)) \
+	X(void, DrawElements, (GLenum mode, GLsizei count, GLenum type, const void *indices), \
+		(mode, count, type, indices)) \
+	X(void, DrawElementsInstanced, (GLenum mode, GLsizei count, GLenum type, \
+		const void *indices, GLsizei instancecount), (mode, count, type, indices, instancecount)) \
+	X(GLuint, CreateShader, (GLenum type), (type)) \
+	X(void, ShaderSource, (GLuint shader, GLsizei count, const GLchar *const *string, \
+		const GLint *length), (shader, count, string, length)) \
+	X(void, CompileShader, (GLuint shader), (shader)) \
+	X(void, GetShaderiv, (GLuint shader, GLenum pname, GLint *params), (shader, pname, params)) \
+	X(void, GetShaderInfoLog, (GLuint shader, GLsizei bufSize, GLsizei *length, \
+		GLchar *infoLog), (shader, bufSize, length, infoLog)) \
+	X(void, DeleteShader, (GLuint shader), (shader)) \
+	X(GLuint, CreateProgram, (), ()) \
+	X(void, AttachShader, (GLuint program, GLuint shader), (program, shader)) \
+	X(void, GetProgramiv, (GLuint program, GLenum pname, GLint *params), \
+		(program, pname, params)) \
+	X(void, GetProgramInfoLog, (GLuint program, GLsizei bufSize, GLsizei *length, \
+		GLchar *infoLog), (program, bufSize, length, infoLog)) \
+	X(void, GetActiveUniform, (GLuint program, GLuint index, GLsizei bufSize, GLsizei *length, \
+		GLint *size, GLenum *type, GLchar *name), (program, index, bufSize, length, size, type, \
+		name)) \
+	X(GLint, GetUniformLocation, (GLuint program, const GLchar *name), (program, name)) \
+	X(GLuint, GetUniformBlockIndex, (GLuint program, const GLchar *uniformBlockName), \
+		(program, uniformBlockName)) \
+	X(void, UniformBlockBinding, (GLuint program, GLuint uniformBlockIndex, \
+		GLuint uniformBlockBinding), (program, uniformBlockIndex, uniformBlockBinding)) \
+	X(GLsync, FenceSync, (GLenum condition, GLbitfield flags), (condition, flags)) \
+	X(GLenum, ClientWaitSync, (GLsync sync, GLbitfield flags, GLuint64 timeout), \
+		(sync, flags, timeout)) \
+	X(void, DeleteSync, (GLsync sync), (sync)) \
+	X(void, BeginQuery, (GLenum target, GLuint id), (target, id)) \
+	X(void, EndQuery, (GLenum target), (target)) \
+	X(void, GetQueryObjectui64v, (GLuint id, GLenum pname, GLuint64 *params), \
+		(id, pname, params)) \
+	X(void, GetIntegerv, (GLenum pname, GLint *data), (pname, data)) \
+	X(const GLubyte *, GetString, (GLenum name), (name)) \
+	X(GLenum, GetError, (), ()) \
+	X(void, Finish, (), ()) \
+	X(void, Flush, (), ())
+
+//functions whose calls are also checked against the state, their wrappers are written below
+#define CHECKED_FUNCTIONS(X) \
+	X(ActiveTexture) X(BindTexture) X(BindBuffer) X(BindBufferBase) X(BindBufferRange) \
+	X(BindVertexArray) X(BindFramebuffer) X(BindRenderbuffer) X(UseProgram) \
+	X(Enable) X(Disable) X(DepthMask) X(DepthFunc) X(BlendFunc) X(BlendFuncSeparate) \
+	X(StencilMask) X(StencilFunc) X(StencilOp) X(ClearColor) X(Viewport) \
+	X(Uniform1i) X(Uniform1f) X(Uniform2fv) X(Uniform3fv) X(Uniform4fv) \
+	X(UniformMatrix3fv) X(UniformMatrix4fv) X(LinkProgram) X(DeleteProgram) \
+	X(DeleteTextures) X(DeleteBuffers) X(DeleteVertexArrays) X(DeleteFramebuffers) \
+	X(DeleteRenderbuffers)
+
+#define COUNTED_ENUM(ret, name, params, args) CALL_##name,
+#define CHECKED_ENUM(name) CALL_##name,
+enum GLFunction {
+	COUNTED_FUNCTIONS(COUNTED_ENUM)
+	CHECKED_FUNCTIONS(CHECKED_ENUM)
+	CALL_COUNT
+};
+
+#define COUNTED_NAME(ret, name, params, args) "gl" #name,
+#define CHECKED_NAME(name) "gl" #name,
+static const char *function_names[CALL_COUNT] = {
+	COUNTED_FUNCTIONS(COUNTED_NAME)
+	CHECKED_FUNCTIONS(CHECKED_NAME)
+};
+
+//entry points of the driver, loaded by glad
+#define COUNTED_REAL(ret, name, params, args) static decltype(glad_gl##name) real_##name = NULL;
+#define CHECKED_REAL(name) static decltype(glad_gl##name) real_##name = NULL;
+COUNTED_FUNCTIONS(COUNTED_REAL)
+CHECKED_FUNCTIONS(CHECKED_REAL)
+
+//calls of every function in the current frame, and how many of them were redundant
+static unsigned int calls[CALL_COUNT];
+static unsigned int redundant[CALL_COUNT];
+
+static void count(GLFunction function, bool same)
+{
+	calls[function]++;
+	if (same)
+		redundant[function]++;
+}
+
+#define COUNTED_WRAPPER(ret, name, params, args) \
+	static ret APIENTRY trace_##name params \
+	{ \
+		calls[CALL_##name]++; \
+		return real_##name args; \
+	}
+COUNTED_FUNCTIONS(COUNTED_WRAPPER)
+
+/*	---------------------------------------------------------------------------------------
+	Traced State
+	---------------------------------------------------------------------------------------	*/
+
+//value of a state that has never been set through the wrappers
+static const GLuint UNKNOWN = ~0u;
+//number of texture units and uniform buffer bindings whose state is traced
+const unsigned int TRACED_TEXTURE_UNITS = 32;
+const unsigned int TRACED_UNIFORM_BINDINGS = 16;
+
+//a state set by one call with up to 4 values
+struct TracedState {
+	GLuint values[4];
+	bool known;
+};
+
+static GLuint active_unit;
+static GLuint textures[3][TRACED_TEXTURE_UNITS];	//2D, buffer and cube map textures
+static GLuint buffers[4];							//see bufferIndex()
+static TracedState uniform_bindings[TRACED_UNIFORM_BINDINGS];	//buffer, offset and size
+static GLuint vertex_array, program, read_framebuffer, draw_framebuffer, renderbuffer;
+static TracedState caps[5];							//see capIndex()
+static TracedState depth_mask, depth_func, blend_func, stencil_mask, stencil_func, stencil_op;
+static TracedState clear_color, viewport;
+
+//value of a uniform, uniforms of more than 64 bytes are not traced
+struct UniformValue {
+	unsigned int size;
+	unsigned char data[64];
+};
+//uniforms of every program, the key is the program in the high 32 bits and the location
+static unordered_map<unsigned long long, UniformValue> uniforms;
+
+static void forgetState()
+{
+	active_unit = UNKNOWN;
+	memset(textures, 0xff, sizeof(textures));
+	memset(buffers, 0xff, sizeof(buffers));
+	vertex_array = program = read_framebuffer = draw_framebuffer = renderbuffer = UNKNOWN;
+	for (unsigned int i = 0; i < 5; i ++)
+		caps[i].known = false;
+	for (unsigned int i = 0; i < TRACED_UNIFORM_BINDINGS; i ++)
+		uniform_bindings[i].known = false;
+	depth_mask.known = depth_func.known = blend_func.known = false;
+	stencil_mask.known = stencil_func.known = stencil_op.known = false;
+	clear_color.known = viewport.known = false;
+	uniforms.clear();
+}
+
+//set a traced value
+//POST:
+//	return true if it already had this value
+static bool update(GLuint &state, GLuint value)
+{
+	bool same = state == value;
+	state = value;
+	return same;
+}
+
+static bool update(TracedState &state, GLuint a, GLuint b = 0, GLuint c = 0, GLuint d = 0)
+{
+	GLuint values[4] = {a, b, c, d};
+	bool same = state.known && memcmp(state.values, values, sizeof(values)) == 0;
+	memcpy(state.values, values, sizeof(values));
+	state.known = true;
+	return same;
+}
+
+static GLuint floatBits(GLfloat value)
+{
+	GLuint bits;
+	memcpy(&bits, &value, sizeof(bits));
+	return bits;
+}
+
+//index of a traced binding target, -1 if the target is not traced
+static int textureIndex(GLenum target)
+{
+	switch (target)
+	{
+		case GL_TEXTURE_2D: return 0;
+		case GL_TEXTURE_BUFFER: return 1;
+		case GL_TEXTURE_CUBE_MAP: return 2;
+		default: return -1;
+	}
+}
+
+static int bufferIndex(GLenum target)
+{
+	switch (target)
+	{
+		case GL_ARRAY_BUFFER: return 0;
+		case GL_ELEMENT_ARRAY_BUFFER: return 1;
+		case GL_UNIFORM_BUFFER: return 2;
+		case GL_TEXTURE_BUFFER: return 3;
+		default: return -1;
+	}
+}
+
+static int capIndex(GLenum cap)
+{
+	switch (cap)
+	{
+		case GL_DEPTH_TEST: return 0;
+		case GL_STENCIL_TEST: return 1;
+		case GL_BLEND: return 2;
+		case GL_CULL_FACE: return 3;
+		case GL_SCISSOR_TEST: return 4;
+		default: return -1;
+	}
+}
+
+//set a uniform of the current program
+//POST:
+//	return true if the uniform already had this value, or if it doesn't exist so that the call
+//	does nothing
+static bool updateUniform(GLint location, const void *data, unsigned int size)
+{
+	if (location == -1)
+		return true;
+	if (program == UNKNOWN || size > sizeof(UniformValue().data))
+		return false;
+	UniformValue &value = uniforms[((unsigned long long)program << 32) | (GLuint)location];
+	bool same = value.size == size && memcmp(value.data, data, size) == 0;
+	value.size = size;
+	memcpy(value.data, data, size);
+	return same;
+}
+
+//uniforms are reset when a program is linked, and gone when it is deleted
+static void forgetProgram(GLuint deleted)
+{
+	for (auto it = uniforms.begin(); it != uniforms.end();)
+	{
+		if ((GLuint)(it->first >> 32) == deleted)
+			it = uniforms.erase(it);
+		else
+			it ++;
+	}
+}
+
+//a deleted object is unbound from every binding point of the context
+static void unbind(GLuint *bindings, unsigned int size, GLuint deleted)
+{
+	for (unsigned int i = 0; i < size; i ++)
+	{
+		if (bindings[i] == deleted)
+			bindings[i] = 0;
+	}
+}
+
+/*	---------------------------------------------------------------------------------------
+	Checked Wrappers
+	---------------------------------------------------------------------------------------	*/
+
+static void APIENTRY trace_ActiveTexture(GLenum texture)
+{
+	count(CALL_ActiveTexture, update(active_unit, texture - GL_TEXTURE0));
+	real_ActiveTexture(texture);
+}
+
+static void APIENTRY trace_BindTexture(GLenum target, GLuint texture)
+{
+	int index = textureIndex(target);
+	bool same = false;
+	if (index >= 0 && active_unit < TRACED_TEXTURE_UNITS)
+		same = update(textures[index][active_unit], texture);
+	count(CALL_BindTexture, same);
+	real_BindTexture(target, texture);
+}
+
+static void APIENTRY trace_BindBuffer(GLenum target, GLuint buffer)
+{
+	int index = bufferIndex(target);
+	count(CALL_BindBuffer, index >= 0 && update(buffers[index], buffer));
+	real_BindBuffer(target, buffer);
+}
+
+static void APIENTRY trace_BindBufferBase(GLenum target, GLuint index, GLuint buffer)
+{
+	bool same = false;
+	if (target == GL_UNIFORM_BUFFER && index < TRACED_UNIFORM_BINDINGS)
+		same = update(uniform_bindings[index], buffer);
+	//the generic binding point is set as well
+	int generic = bufferIndex(target);
+	if (generic >= 0)
+		buffers[generic] = buffer;
+	count(CALL_BindBufferBase, same);
+	real_BindBufferBase(target, index, buffer);
+}
+
+static void APIENTRY trace_BindBufferRange(GLenum target, GLuint index, GLuint buffer,
+	GLintptr offset, GLsizeiptr size)
+{
+	//a range has a size, so it never matches a whole buffer bound by glBindBufferBase
+	bool same = false;
+	if (target == GL_UNIFORM_BUFFER && index < TRACED_UNIFORM_BINDINGS)
+		same = update(uniform_bindings[index], buffer, (GLuint)offset, (GLuint)size);
+	int generic = bufferIndex(target);
+	if (generic >= 0)
+		buffers[generic] = buffer;
+	count(CALL_BindBufferRange, same);
+	real_BindBufferRange(target, index, buffer, offset, size);
+}
+
+static void APIENTRY trace_BindVertexArray(GLuint array)
+{
+	bool same = update(vertex_array, array);
+	//the element buffer is a state of the vertex array
+	if (!same)
+		buffers[bufferIndex(GL_ELEMENT_ARRAY_BUFFER)] = UNKNOWN;
+	count(CALL_BindVertexArray, same);
+	real_BindVertexArray(array);
+}
+
+static void APIENTRY trace_BindFramebuffer(GLenum target, GLuint framebuffer)
+{
+	bool same = false;
+	if (target == GL_FRAMEBUFFER)
+	{
+		same = read_framebuffer == framebuffer && draw_framebuffer == framebuffer;
+		read_framebuffer = draw_framebuffer = framebuffer;
+	}
+	else if (target == GL_READ_FRAMEBUFFER)
+		same = update(read_framebuffer, framebuffer);
+	else if (target == GL_DRAW_FRAMEBUFFER)
+		same = update(draw_framebuffer, framebuffer);
+	count(CALL_BindFramebuffer, same);
+	real_BindFramebuffer(target, framebuffer);
+}
+
+static void APIENTRY trace_BindRenderbuffer(GLenum target, GLuint buffer)
+{
+	count(CALL_BindRenderbuffer, update(renderbuffer, buffer));
+	real_BindRenderbuffer(target, buffer);
+}
+
+static void APIENTRY trace_UseProgram(GLuint used)
+{
+	count(CALL_UseProgram, update(program, used));
+	real_UseProgram(used);
+}
+
+static void APIENTRY trace_Enable(GLenum cap)
+{
+	int index = capIndex(cap);
+	count(CALL_Enable, index >= 0 && update(caps[index], GL_TRUE));
+	real_Enable(cap);
+}
+
+static void APIENTRY trace_Disable(GLenum cap)
+{
+	int index = capIndex(cap);
+	count(CALL_Disable, index >= 0 && update(caps[index], GL_FALSE));
+	real_Disable(cap);
+}
+
+static void APIENTRY trace_DepthMask(GLboolean flag)
+{
+	count(CALL_DepthMask, update(depth_mask, flag));
+	real_DepthMask(flag);
+}
+
+static void APIENTRY trace_DepthFunc(GLenum func)
+{
+	count(CALL_DepthFunc, update(depth_func, func));
+	real_DepthFunc(func);
+}
+
+static void APIENTRY trace_BlendFunc(GLenum sfactor, GLenum dfactor)
+{
+	count(CALL_BlendFunc, update(blend_func, sfactor, dfactor, sfactor, dfactor));
+	real_BlendFunc(sfactor, dfactor);
+}
+
+static void APIENTRY trace_BlendFuncSeparate(GLenum sfactorRGB, GLenum dfactorRGB,
+	GLenum sfactorAlpha, GLenum dfactorAlpha)
+{
+	count(CALL_BlendFuncSeparate, update(blend_func, sfactorRGB, dfactorRGB, sfactorAlpha,
+		dfactorAlpha));
+	real_BlendFuncSeparate(sfactorRGB, dfactorRGB, sfactorAlpha, dfactorAlpha);
+}
+
+static void APIENTRY trace_StencilMask(GLuint mask)
+{
+	count(CALL_StencilMask, update(stencil_mask, mask));
+	real_StencilMask(mask);
+}
+
+static void APIENTRY trace_StencilFunc(GLenum func, GLint ref, GLuint mask)
+{
+	count(CALL_StencilFunc, update(stencil_func, func, ref, mask));
+	real_StencilFunc(func, ref, mask);
+}
+
+static void APIENTRY trace_StencilOp(GLenum fail, GLenum zfail, GLenum zpass)
+{
+	count(CALL_StencilOp, update(stencil_op, fail, zfail, zpass));
+	real_StencilOp(fail, zfail, zpass);
+}
+
+static void APIENTRY trace_ClearColor(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha)
+{
+	count(CALL_ClearColor, update(clear_color, floatBits(red), floatBits(green), floatBits(blue),
+		floatBits(alpha)));
+	real_ClearColor(red, green, blue, alpha);
+}
+
+static void APIENTRY trace_Viewport(GLint x, GLint y, GLsizei width, GLsizei height)
+{
+	count(CALL_Viewport, update(viewport, x, y, width, height));
+	real_Viewport(x, y, width, height);
+}
+
+static void APIENTRY trace_Uniform1i(GLint location, GLint v0)
+{
+	count(CALL_Uniform1i, updateUniform(location, &v0, sizeof(v0)));
+	real_Uniform1i(location, v0);
+}
+
+static void APIENTRY trace_Uniform1f(GLint location, GLfloat v0)
+{
+	count(CALL_Uniform1f, updateUniform(location, &v0, sizeof(v0)));
+	real_Uniform1f(location, v0);
+}
+
+static void APIENTRY trace_Uniform2fv(GLint location, GLsizei n, const GLfloat *value)
+{
+	count(CALL_Uniform2fv, updateUniform(location, value, n * 2 * sizeof(GLfloat)));
+	real_Uniform2fv(location, n, value);
+}
+
+static void APIENTRY trace_Uniform3fv(GLint location, GLsizei n, const GLfloat *value)
+{
+	count(CALL_Uniform3fv, updateUniform(location, value, n * 3 * sizeof(GLfloat)));
+	real_Uniform3fv(location, n, value);
+}
+
+static void APIENTRY trace_Uniform4fv(GLint location, GLsizei n, const GLfloat *value)
+{
+	count(CALL_Uniform4fv, updateUniform(location, value, n * 4 * sizeof(GLfloat)));
+	real_Uniform4fv(location, n, value);
+}
+
+//matrices set transposed are never redundant, the renderer never transposes them
+static void APIENTRY trace_UniformMatrix3fv(GLint location, GLsizei n, GLboolean transpose,
+	const GLfloat *value)
+{
+	bool same = updateUniform(location, value, n * 9 * sizeof(GLfloat));
+	count(CALL_UniformMatrix3fv, same && !transpose);
+	real_UniformMatrix3fv(location, n, transpose, value);
+}
+
+static void APIENTRY trace_UniformMatrix4fv(GLint location, GLsizei n, GLboolean transpose,
+	const GLfloat *value)
+{
+	bool same = updateUniform(location, value, n * 16 * sizeof(GLfloat));
+	count(CALL_UniformMatrix4fv, same && !transpose);
+	real_UniformMatrix4fv(location, n, transpose, value);
+}
+
+static void APIENTRY trace_LinkProgram(GLuint linked)
+{
+	forgetProgram(linked);
+	count(CALL_LinkProgram, false);
+	real_LinkProgram(linked);
+}
+
+static void APIENTRY trace_DeleteProgram(GLuint deleted)
+{
+	forgetProgram(deleted);
+	count(CALL_DeleteProgram, false);
+	real_DeleteProgram(deleted);
+}
+
+static void APIENTRY trace_DeleteTextures(GLsizei n, const GLuint *deleted)
+{
+	for (GLsizei i = 0; i < n; i ++)
+		unbind(&textures[0][0], 3 * TRACED_TEXTURE_UNITS, deleted[i]);
+	count(CALL_DeleteTextures, false);
+	real_DeleteTextures(n, deleted);
+}
+
+static void APIENTRY trace_DeleteBuffers(GLsizei n, const GLuint *deleted)
+{
+	for (GLsizei i = 0; i < n; i ++)
+	{
+		unbind(buffers, 4, deleted[i]);
+		for (unsigned int j = 0; j < TRACED_UNIFORM_BINDINGS; j ++)
+		{
+			if (uniform_bindings[j].known && uniform_bindings[j].values[0] == deleted[i])
+				update(uniform_bindings[j], 0);
+		}
+	}
+	count(CALL_DeleteBuffers, false);
+	real_DeleteBuffers(n, deleted);
+}
+
+static void APIENTRY trace_DeleteVertexArrays(GLsizei n, const GLuint *deleted)
+{
+	for (GLsizei i = 0; i < n; i ++)
+	{
+		if (vertex_array == deleted[i])
+		{
+			vertex_array = 0;
+			buffers[bufferIndex(GL_ELEMENT_ARRAY_BUFFER)] = UNKNOWN;
+		}
+	}
+	count(CALL_DeleteVertexArrays, false);
+	real_DeleteVertexArrays(n, deleted);
+}
+
+static void APIENTRY trace_DeleteFramebuffers(GLsizei n, const GLuint *deleted)
+{
+	for (GLsizei i = 0; i < n; i ++)
+	{
+		unbind(&read_framebuffer, 1, deleted[i]);
+		unbind(&draw_framebuffer, 1, deleted[i]);
+	}
+	count(CALL_DeleteFramebuffers, false);
+	real_DeleteFramebuffers(n, deleted);
+}
+
+static void APIENTRY trace_DeleteRenderbuffers(GLsizei n, const GLuint *deleted)
+{
+	for (GLsizei i = 0; i < n; i ++)
+		unbind(&renderbuffer, 1, deleted[i]);
+	count(CALL_DeleteRenderbuffers, false);
+	real_DeleteRenderbuffers(n, deleted);
+}
+
+/*	---------------------------------------------------------------------------------------
+	GLTrace
+	---------------------------------------------------------------------------------------	*/
+
+bool GLTrace::installed = false;
+unsigned int GLTrace::frame = 0;
+
+//functions the driver doesn't have stay NULL
+#define COUNTED_INSTALL(ret, name, params, args) CHECKED_INSTALL(name)
+#define CHECKED_INSTALL(name) \
+	real_##name = glad_gl##name; \
+	if (real_##name) \
+		glad_gl##name = trace_##name;
+
+void GLTrace::install()
+{
+	if (installed)
+		return;
+	forgetState();
+	COUNTED_FUNCTIONS(COUNTED_INSTALL)
+	CHECKED_FUNCTIONS(CHECKED_INSTALL)
+	installed = true;
+	beginFrame();
+}
+
+void GLTrace::beginFrame()
+{
+	memset(calls, 0, sizeof(calls));
+	memset(redundant, 0, sizeof(redundant));
+	frame++;
+}
+
+unsigned int GLTrace::getCalls()
+{
+	unsigned int total = 0;
+	for (unsigned int i = 0; i < CALL_COUNT; i ++)
+		total += calls[i];
+	return total;
+}
+
+unsigned int GLTrace::getRedundant()
+{
+	unsigned int total = 0;
+	for (unsigned int i = 0; i < CALL_COUNT; i ++)
+		total += redundant[i];
+	return total;
+}
+
+static bool busier(unsigned int a, unsigned int b)
+{
+	return calls[a] > calls[b];
+}
+
+void GLTrace::printFrame(ostream &out)
+{
+	vector<unsigned int> called;
+	for (unsigned int i = 0; i < CALL_COUNT; i ++)
+	{
+		if (calls[i])
+			called.push_back(i);
+	}
+	stable_sort(called.begin(), called.end(), busier);
+
+	out << "GL calls of frame " << frame << ": " << getCalls() << ", " << getRedundant()
+		<< " redundant" << endl;
+	for (unsigned int i = 0; i < called.size(); i ++)
+	{
+		out << "\t" << function_names[called[i]] << ": " << calls[called[i]];
+		if (redundant[called[i]])
+			out << ", " << redundant[called[i]] << " redundant";
+		out << endl;
+	}
+}
@@ -0,0 +1,181 @@
+#include "../include/headless.h"
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <cstring>
+
+#ifdef HEADLESS_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+using namespace std;
+
+void initGLState()
+{
+	glEnable(GL_DEPTH_TEST);
+	glEnable(GL_STENCIL_TEST);
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	glDepthFunc(GL_LESS);
+}
+
+HeadlessContext::HeadlessContext(unsigned int width, unsigned int height) :
+	width(width), height(height), display(NULL), surface(NULL), context(NULL), fbo(0),
+	color(0), depth(0), complete(false)
+{
+	if (!createContext())
+		return;
+	complete = createFramebuffer();
+}
+
+HeadlessContext::~HeadlessContext()
+{
+	if (fbo)
+	{
+		glDeleteFramebuffers(1, &fbo);
+		glDeleteRenderbuffers(1, &color);
+		glDeleteRenderbuffers(1, &depth);
+	}
+#ifdef HEADLESS_EGL
+	if (display)
+	{
+		eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+		if (context)
+			eglDestroyContext(display, context);
+		if (surface)
+			eglDestroySurface(display, surface);
+		eglTerminate(display);
+	}
+#endif
+}
+
+#ifdef HEADLESS_EGL
+bool HeadlessContext::createContext()
+{
+	//Mesa can run without any window system on its surfaceless platform, other drivers use
+	//their default display
+	EGLDisplay egl_display = EGL_NO_DISPLAY;
+	const char *extensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+	if (extensions && strstr(extensions, "EGL_MESA_platform_surfaceless"))
+	{
+		PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+			(PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+		if (getPlatformDisplay)
+			egl_display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY,
+				NULL);
+	}
+	if (egl_display == EGL_NO_DISPLAY)
+		egl_display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+	if (egl_display == EGL_NO_DISPLAY || !eglInitialize(egl_display, NULL, NULL))
+	{
+		cout << "ERROR::HEADLESS::EGL_DISPLAY_NOT_AVAILABLE" << endl;
+		return false;
+	}
+	display = egl_display;
+
+	const EGLint config_attribs[] = {
+		EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+		EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+		EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8, EGL_ALPHA_SIZE, 8,
+		EGL_NONE
+	};
+	EGLConfig config;
+	EGLint config_num = 0;
+	if (!eglChooseConfig(egl_display, config_attribs, &config, 1, &config_num) ||
+		config_num == 0 || !eglBindAPI(EGL_OPENGL_API))
+	{
+		cout << "ERROR::HEADLESS::EGL_OPENGL_NOT_SUPPORTED" << endl;
+		return false;
+	}
+
+	//same version and profile as the window, see initWindow()
+	const EGLint context_attribs[] = {
+		EGL_CONTEXT_MAJOR_VERSION_KHR, 3,
+		EGL_CONTEXT_MINOR_VERSION_KHR, 3,
+		EGL_CONTEXT_OPENGL_PROFILE_MASK_KHR, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT_KHR,
+		EGL_NONE
+	};
+	context = eglCreateContext(egl_display, config, EGL_NO_CONTEXT, context_attribs);
+	if (context == EGL_NO_CONTEXT)
+	{
+		context = NULL;
+		cout << "ERROR::HEADLESS::EGL_CONTEXT_NOT_CREATED" << endl;
+		return false;
+	}
+	//frames are drawn into the framebuffer object, the surface is only needed by drivers
+	//that can't make a context current without one
+	const EGLint surface_attribs[] = {EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE};
+	surface = eglCreatePbufferSurface(egl_display, config, surface_attribs);
+	if (surface == EGL_NO_SURFACE)
+		surface = NULL;
+	EGLSurface egl_surface = surface ? surface : EGL_NO_SURFACE;
+	if (!eglMakeCurrent(egl_display, egl_surface, egl_surface, context))
+	{
+		cout << "ERROR::HEADLESS::EGL_CONTEXT_NOT_CURRENT" << endl;
+		return false;
+	}
+
+	if (!gladLoadGLLoader((GLADloadproc)eglGetProcAddress))
+	{
+		cout << "Failed to load glad" << endl;
+		return false;
+	}
+	return true;
+}
+#else
+bool HeadlessContext::createContext()
+{
+	cout << "ERROR::HEADLESS::BUILT_WITHOUT_EGL" << endl;
+	return false;
+}
+#endif
+
+bool HeadlessContext::createFramebuffer()
+{
+	glGenRenderbuffers(1, &color);
+	glBindRenderbuffer(GL_RENDERBUFFER, color);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+	glGenRenderbuffers(1, &depth);
+	glBindRenderbuffer(GL_RENDERBUFFER, depth);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	glGenFramebuffers(1, &fbo);
+	glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, color);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depth);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+	{
+		cout << "ERROR::FRAMEBUFFER::HEADLESS_BUFFER_NOT_COMPLETE" << endl;
+		return false;
+	}
+	glViewport(0, 0, width, height);
+	return true;
+}
+
+void HeadlessContext::bind()
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+	glViewport(0, 0, width, height);
+}
+
+bool HeadlessContext::saveImage(const string &path)
+{
+	vector<unsigned char> pixels(width * height * 3);
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, &pixels[0]);
+
+	ofstream file(path.c_str(), ios::binary);
+	if (!file)
+	{
+		cout << "ERROR::HEADLESS::IMAGE_NOT_WRITTEN: " << path << endl;
+		return false;
+	}
+	file << "P6\n" << width << " " << height << "\n255\n";
+	//rows are read from the bottom, images start at the top
+	for (unsigned int row = height; row > 0; row --)
+		file.write((const char*)&pixels[(row - 1) * width * 3], width * 3);
+	return file.good();
+}
@@ -0,0 +1,100 @@
+#include "../include/instancedModel.h"
+#include <algorithm>
+
+using namespace std;
+using namespace glm;
+
+InstancedModel::InstancedModel(const Model &_model) : model(_model)
+{
+	capacity = 0;
+	dirty = false;
+	bounds_dirty = false;
+
+	glGenBuffers(1, &instance_vbo);
+	for (unsigned int i = 0; i < model.meshes.size(); i ++)
+		model.meshes[i].setInstanceBuffer(instance_vbo);
+}
+
+unsigned int InstancedModel::addInstance(const mat4 &transform)
+{
+	transforms.push_back(transform);
+	dirty = true;
+	//adding only grows the bounds
+	if (!bounds_dirty)
+		world_bounds.merge(model.bounds.transform(transform));
+	return transforms.size() - 1;
+}
+
+unsigned int InstancedModel::addInstance(vec3 pos, float angle, vec3 rotate, vec3 scale)
+{
+	mat4 transform = glm::translate(mat4(1.0), pos);
+	transform = glm::rotate(transform, radians(angle), rotate);
+	transform = glm::scale(transform, scale);
+	return addInstance(transform);
+}
+
+void InstancedModel::setInstance(unsigned int index, const mat4 &transform)
+{
+	if (index >= transforms.size())
+		return;
+	transforms[index] = transform;
+	dirty = true;
+	bounds_dirty = true;
+}
+
+void InstancedModel::removeInstance(unsigned int index)
+{
+	if (index >= transforms.size())
+		return;
+	transforms[index] = transforms.back();
+	transforms.pop_back();
+	dirty = true;
+	bounds_dirty = true;
+}
+
+const Bounds& InstancedModel::getWorldBounds()
+{
+	if (bounds_dirty)
+	{
+		world_bounds = Bounds();
+		for (unsigned int i = 0; i < transforms.size(); i ++)
+			world_bounds.merge(model.bounds.transform(transforms[i]));
+		bounds_dirty = false;
+	}
+	return world_bounds;
+}
+
+void InstancedModel::upload()
+{
+	if (!dirty || transforms.empty())
+		return;
+
+	glBindBuffer(GL_ARRAY_BUFFER, instance_vbo);
+	if (transforms.size() > capacity)
+	{
+		//grow geometrically so that adding instances one by one doesn't reallocate every frame
+		capacity = std::max((unsigned int)transforms.size(), capacity * 2);
+		glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(mat4), NULL, GL_DYNAMIC_DRAW);
+	}
+	glBufferSubData(GL_ARRAY_BUFFER, 0, transforms.size() * sizeof(mat4), transforms.data());
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	dirty = false;
+}
+
+void InstancedModel::releaseBuffer()
+{
+	glDeleteBuffers(1, &instance_vbo);
+	instance_vbo = 0;
+	capacity = 0;
+}
+
+void InstancedModel::render()
+{
+	if (transforms.empty())
+		return;
+
+	upload();
+	model.shader->use();
+	for (unsigned int i = 0; i < model.uploaded; i ++)
+		model.meshes[i].renderInstanced(transforms.size());
+}
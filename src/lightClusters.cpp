@@ -0,0 +1,359 @@
+#include "../include/lightClusters.h"
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+#include "glState.h"
+#include "shader.h"
+
+#if GLM_ARCH & GLM_ARCH_SSE2_BIT
+#include <emmintrin.h>
+#endif
+
+using namespace std;
+using namespace glm;
+
+LightClusters::LightClusters() : capacity(CLUSTERS_NUM), valid(false), job_num(0), jobs_left(0),
+	index_count(0)
+{
+	glGenBuffers(1, &buffer);
+	glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+	glBufferData(GL_TEXTURE_BUFFER, capacity * 4 * sizeof(uint32_t), NULL, GL_STREAM_DRAW);
+	glBindBuffer(GL_TEXTURE_BUFFER, 0);
+	glGenTextures(1, &texture);
+	GLState::bindTexture(LIGHTS_TEXTURE_UNIT, texture, GL_TEXTURE_BUFFER);
+	glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32UI, buffer);
+	memset(grid, 0, sizeof(grid));
+}
+
+LightClusters::~LightClusters()
+{
+	//workers may still be binning
+	workers.reset();
+	glDeleteTextures(1, &texture);
+	GLState::textureDeleted(texture);
+	glDeleteBuffers(1, &buffer);
+}
+
+void LightClusters::setProjection(const mat4 &proj, float near, float far, unsigned int width,
+	unsigned int height)
+{
+	tile = vec2(ceil(float(width) / CLUSTERS_X), ceil(float(height) / CLUSTERS_Y));
+	float log_ratio = log(far / near);
+	depth = vec2(CLUSTERS_Z / log_ratio, -(CLUSTERS_Z * log(near)) / log_ratio);
+
+	slice_near.resize(CLUSTERS_Z + 1);
+	for (unsigned int z = 0; z <= CLUSTERS_Z; z ++)
+		slice_near[z] = near * pow(far / near, float(z) / CLUSTERS_Z);
+
+	min_x.resize(CLUSTERS_NUM); min_y.resize(CLUSTERS_NUM); min_z.resize(CLUSTERS_NUM);
+	max_x.resize(CLUSTERS_NUM); max_y.resize(CLUSTERS_NUM); max_z.resize(CLUSTERS_NUM);
+	center_x.resize(CLUSTERS_NUM); center_y.resize(CLUSTERS_NUM);
+	center_z.resize(CLUSTERS_NUM); radius.resize(CLUSTERS_NUM);
+
+	mat4 inv = inverse(proj);
+	for (unsigned int y = 0; y < CLUSTERS_Y; y ++)
+	{
+		for (unsigned int x = 0; x < CLUSTERS_X; x ++)
+		{
+			//rays through the corners of the tile, given by a point on the near and far plane
+			float ndc_x[2] = {std::min(x * tile.x / width, 1.0f) * 2 - 1,
+				std::min((x + 1) * tile.x / width, 1.0f) * 2 - 1};
+			float ndc_y[2] = {std::min(y * tile.y / height, 1.0f) * 2 - 1,
+				std::min((y + 1) * tile.y / height, 1.0f) * 2 - 1};
+			vec3 ray_near[4], ray_far[4];
+			for (unsigned int i = 0; i < 4; i ++)
+			{
+				vec4 n = inv * vec4(ndc_x[i & 1], ndc_y[i >> 1], -1.0f, 1.0f);
+				vec4 f = inv * vec4(ndc_x[i & 1], ndc_y[i >> 1], 1.0f, 1.0f);
+				ray_near[i] = vec3(n) / n.w;
+				ray_far[i] = vec3(f) / f.w;
+			}
+
+			for (unsigned int z = 0; z < CLUSTERS_Z; z ++)
+			{
+				//corners of the cluster are where the rays cross both ends of the slice
+				vec3 lo(INFINITY), hi(-INFINITY);
+				for (unsigned int i = 0; i < 8; i ++)
+				{
+					float d = slice_near[z + (i >> 2)];
+					vec3 a = ray_near[i & 3], b = ray_far[i & 3];
+					vec3 p = a + (b - a) * ((-d - a.z) / (b.z - a.z));
+					lo = glm::min(lo, p);
+					hi = glm::max(hi, p);
+				}
+				unsigned int c = (z * CLUSTERS_Y + y) * CLUSTERS_X + x;
+				min_x[c] = lo.x; min_y[c] = lo.y; min_z[c] = lo.z;
+				max_x[c] = hi.x; max_y[c] = hi.y; max_z[c] = hi.z;
+				vec3 center = (lo + hi) * 0.5f;
+				center_x[c] = center.x; center_y[c] = center.y; center_z[c] = center.z;
+				radius[c] = length(hi - lo) * 0.5f;
+			}
+		}
+	}
+	valid = false;
+}
+
+bool LightClusters::update(const mat4 &view, const PointLight *points, unsigned int point_num,
+	const SpotLight *spots, unsigned int spot_num)
+{
+	GLState::bindTexture(LIGHTS_TEXTURE_UNIT, texture, GL_TEXTURE_BUFFER);
+
+	next_records.resize(point_num + spot_num);
+	for (unsigned int i = 0; i < point_num; i ++)
+		points[i].fillRecord(next_records[i]);
+	for (unsigned int i = 0; i < spot_num; i ++)
+		spots[i].fillRecord(next_records[point_num + i]);
+	//lights can be changed through their pointers, so compare every record
+	if (valid && view == last_view && next_records.size() == records.size() &&
+		memcmp(next_records.data(), records.data(), records.size() * sizeof(LightRecord)) == 0)
+		return false;
+	records.swap(next_records);
+	last_view = view;
+	valid = true;
+
+	point_x.clear(); point_y.clear(); point_z.clear(); point_r.clear(); point_ids.clear();
+	spot_x.clear(); spot_y.clear(); spot_z.clear(); spot_ids.clear();
+	dir_x.clear(); dir_y.clear(); dir_z.clear(); spot_cos.clear(); spot_sin.clear();
+	for (unsigned int i = 0; i < point_num; i ++)
+	{
+		vec4 center = view * vec4(records[i].position, 1.0f);
+		point_x.push_back(center.x);
+		point_y.push_back(center.y);
+		point_z.push_back(center.z);
+		point_r.push_back(points[i].getRange());
+		point_ids.push_back(i);
+	}
+	for (unsigned int i = point_num; i < records.size(); i ++)
+	{
+		const LightRecord &record = records[i];
+		vec4 apex = view * vec4(record.position, 1.0f);
+		vec3 dir = mat3(view) * record.direction;
+		float len = length(dir);
+		if (record.outer_cutoff <= 0.0f || len == 0.0f)
+		{
+			//the cone test only works for cones narrower than a half space
+			point_x.push_back(apex.x);
+			point_y.push_back(apex.y);
+			point_z.push_back(apex.z);
+			point_r.push_back(INFINITY);
+			point_ids.push_back(i);
+			continue;
+		}
+		dir /= len;
+		spot_x.push_back(apex.x);
+		spot_y.push_back(apex.y);
+		spot_z.push_back(apex.z);
+		dir_x.push_back(dir.x);
+		dir_y.push_back(dir.y);
+		dir_z.push_back(dir.z);
+		spot_cos.push_back(record.outer_cutoff);
+		spot_sin.push_back(sqrt(1.0f - record.outer_cutoff * record.outer_cutoff));
+		spot_ids.push_back(i);
+	}
+	//padding is never appended, see appendLights()
+	unsigned int spot_size = (spot_ids.size() + 3) & ~3u;
+	spot_x.resize(spot_size); spot_y.resize(spot_size); spot_z.resize(spot_size);
+	dir_x.resize(spot_size); dir_y.resize(spot_size); dir_z.resize(spot_size);
+	spot_cos.resize(spot_size); spot_sin.resize(spot_size);
+
+	binAll();
+	upload();
+	return true;
+}
+
+void LightClusters::fillBlock(LightsBlock &block) const
+{
+	block.clusters[0] = CLUSTERS_X;
+	block.clusters[1] = CLUSTERS_Y;
+	block.clusters[2] = CLUSTERS_Z;
+	block.tile = tile;
+	block.depth = depth;
+}
+
+void LightClusters::binAll()
+{
+	job_num = 1;
+	if (point_ids.size() + spot_ids.size() >= PARALLEL_BINNING_LIGHTS)
+	{
+		if (!workers)
+			workers.reset(new ThreadPool());
+		job_num = std::min(workers->size() + 1, CLUSTERS_Z);
+	}
+	if (jobs.size() < job_num)
+		jobs.resize(job_num);
+	for (unsigned int i = 0; i < job_num; i ++)
+	{
+		jobs[i].first_slice = i * CLUSTERS_Z / job_num;
+		jobs[i].last_slice = (i + 1) * CLUSTERS_Z / job_num;
+	}
+
+	if (job_num == 1)
+	{
+		bin(jobs[0]);
+		return;
+	}
+	jobs_left = job_num - 1;
+	for (unsigned int i = 1; i < job_num; i ++)
+	{
+		workers->push([this, i]() {
+			bin(jobs[i]);
+			lock_guard<mutex> lock(jobs_mutex);
+			if (--jobs_left == 0)
+				jobs_done.notify_one();
+		});
+	}
+	//the rendering thread bins the first slices
+	bin(jobs[0]);
+	unique_lock<mutex> lock(jobs_mutex);
+	jobs_done.wait(lock, [this]() {return jobs_left == 0;});
+}
+
+//append the lights whose bits are set in mask, lights at and after count are padding
+static void appendLights(int mask, const unsigned int *ids, unsigned int first,
+	unsigned int count, vector<unsigned int> &indices)
+{
+	for (unsigned int i = 0; i < 4 && first + i < count; i ++)
+	{
+		if (mask >> i & 1)
+			indices.push_back(ids[first + i]);
+	}
+}
+
+void LightClusters::bin(BinJob &job)
+{
+	job.indices.clear();
+	unsigned int spot_num = spot_ids.size();
+	for (unsigned int z = job.first_slice; z < job.last_slice; z ++)
+	{
+		//only point lights overlapping the slice are tested against its clusters
+		float near = slice_near[z], far = slice_near[z + 1];
+		job.x.clear(); job.y.clear(); job.z.clear(); job.r2.clear(); job.ids.clear();
+		for (unsigned int i = 0; i < point_ids.size(); i ++)
+		{
+			if (-point_z[i] + point_r[i] < near || -point_z[i] - point_r[i] > far)
+				continue;
+			job.x.push_back(point_x[i]);
+			job.y.push_back(point_y[i]);
+			job.z.push_back(point_z[i]);
+			job.r2.push_back(point_r[i] * point_r[i]);
+			job.ids.push_back(point_ids[i]);
+		}
+		unsigned int point_num = job.ids.size();
+		unsigned int point_size = (point_num + 3) & ~3u;
+		job.x.resize(point_size); job.y.resize(point_size);
+		job.z.resize(point_size); job.r2.resize(point_size);
+
+		for (unsigned int c = z * CLUSTERS_X * CLUSTERS_Y; c < (z + 1) * CLUSTERS_X * CLUSTERS_Y;
+			c ++)
+		{
+			unsigned int offset = job.indices.size();
+#if GLM_ARCH & GLM_ARCH_SSE2_BIT
+			//4 lights are tested against the cluster at once
+			__m128 zero = _mm_setzero_ps();
+			__m128 lo_x = _mm_set1_ps(min_x[c]), hi_x = _mm_set1_ps(max_x[c]);
+			__m128 lo_y = _mm_set1_ps(min_y[c]), hi_y = _mm_set1_ps(max_y[c]);
+			__m128 lo_z = _mm_set1_ps(min_z[c]), hi_z = _mm_set1_ps(max_z[c]);
+			for (unsigned int i = 0; i < point_num; i += 4)
+			{
+				//distance from the sphere's center to the box
+				__m128 x = _mm_loadu_ps(&job.x[i]);
+				__m128 y = _mm_loadu_ps(&job.y[i]);
+				__m128 z = _mm_loadu_ps(&job.z[i]);
+				__m128 dx = _mm_max_ps(_mm_max_ps(_mm_sub_ps(lo_x, x), _mm_sub_ps(x, hi_x)), zero);
+				__m128 dy = _mm_max_ps(_mm_max_ps(_mm_sub_ps(lo_y, y), _mm_sub_ps(y, hi_y)), zero);
+				__m128 dz = _mm_max_ps(_mm_max_ps(_mm_sub_ps(lo_z, z), _mm_sub_ps(z, hi_z)), zero);
+				__m128 d2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)),
+					_mm_mul_ps(dz, dz));
+				int mask = _mm_movemask_ps(_mm_cmple_ps(d2, _mm_loadu_ps(&job.r2[i])));
+				appendLights(mask, job.ids.data(), i, point_num, job.indices);
+			}
+
+			__m128 cx = _mm_set1_ps(center_x[c]);
+			__m128 cy = _mm_set1_ps(center_y[c]);
+			__m128 cz = _mm_set1_ps(center_z[c]);
+			__m128 r = _mm_set1_ps(radius[c]);
+			__m128 neg_r = _mm_sub_ps(zero, r);
+			for (unsigned int i = 0; i < spot_num; i += 4)
+			{
+				//cone against the cluster's bounding sphere
+				__m128 vx = _mm_sub_ps(cx, _mm_loadu_ps(&spot_x[i]));
+				__m128 vy = _mm_sub_ps(cy, _mm_loadu_ps(&spot_y[i]));
+				__m128 vz = _mm_sub_ps(cz, _mm_loadu_ps(&spot_z[i]));
+				__m128 len2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, vx), _mm_mul_ps(vy, vy)),
+					_mm_mul_ps(vz, vz));
+				__m128 along = _mm_add_ps(_mm_add_ps(
+					_mm_mul_ps(vx, _mm_loadu_ps(&dir_x[i])),
+					_mm_mul_ps(vy, _mm_loadu_ps(&dir_y[i]))),
+					_mm_mul_ps(vz, _mm_loadu_ps(&dir_z[i])));
+				__m128 across = _mm_sqrt_ps(_mm_max_ps(_mm_sub_ps(len2,
+					_mm_mul_ps(along, along)), zero));
+				__m128 dist = _mm_sub_ps(_mm_mul_ps(_mm_loadu_ps(&spot_cos[i]), across),
+					_mm_mul_ps(along, _mm_loadu_ps(&spot_sin[i])));
+				int mask = _mm_movemask_ps(_mm_and_ps(_mm_cmple_ps(dist, r),
+					_mm_cmpge_ps(along, neg_r)));
+				appendLights(mask, spot_ids.data(), i, spot_num, job.indices);
+			}
+#else
+			for (unsigned int i = 0; i < point_num; i ++)
+			{
+				float dx = std::max(std::max(min_x[c] - job.x[i], job.x[i] - max_x[c]), 0.0f);
+				float dy = std::max(std::max(min_y[c] - job.y[i], job.y[i] - max_y[c]), 0.0f);
+				float dz = std::max(std::max(min_z[c] - job.z[i], job.z[i] - max_z[c]), 0.0f);
+				if (dx * dx + dy * dy + dz * dz <= job.r2[i])
+					job.indices.push_back(job.ids[i]);
+			}
+			for (unsigned int i = 0; i < spot_num; i ++)
+			{
+				vec3 v = vec3(center_x[c] - spot_x[i], center_y[c] - spot_y[i],
+					center_z[c] - spot_z[i]);
+				float along = dot(v, vec3(dir_x[i], dir_y[i], dir_z[i]));
+				float across = sqrt(std::max(dot(v, v) - along * along, 0.0f));
+				float dist = spot_cos[i] * across - along * spot_sin[i];
+				if (dist <= radius[c] && along >= -radius[c])
+					job.indices.push_back(spot_ids[i]);
+			}
+#endif
+			grid[c][0] = offset;
+			grid[c][1] = job.indices.size() - offset;
+		}
+	}
+}
+
+void LightClusters::upload()
+{
+	unsigned int record_base = CLUSTERS_NUM;
+	unsigned int index_base = record_base + records.size() * (sizeof(LightRecord) / 16);
+	index_count = 0;
+	for (unsigned int i = 0; i < job_num; i ++)
+		index_count += jobs[i].indices.size();
+	unsigned int size = index_base + (index_count + 3) / 4;
+	texels.resize(size * 4);
+
+	unsigned int base = 0;
+	for (unsigned int i = 0; i < job_num; i ++)
+	{
+		const BinJob &job = jobs[i];
+		for (unsigned int c = job.first_slice * CLUSTERS_X * CLUSTERS_Y;
+			c < job.last_slice * CLUSTERS_X * CLUSTERS_Y; c ++)
+		{
+			texels[c * 4] = base + grid[c][0];
+			texels[c * 4 + 1] = grid[c][1];
+			texels[c * 4 + 2] = texels[c * 4 + 3] = 0;
+		}
+		if (!job.indices.empty())
+			memcpy(&texels[index_base * 4 + base], job.indices.data(),
+				job.indices.size() * sizeof(uint32_t));
+		base += job.indices.size();
+	}
+	if (!records.empty())
+		memcpy(&texels[record_base * 4], records.data(), records.size() * sizeof(LightRecord));
+
+	glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+	if (size > capacity)
+		capacity = std::max(size, capacity * 2);
+	//the previous content may still be read by the GPU, orphan it instead of waiting
+	glBufferData(GL_TEXTURE_BUFFER, capacity * 4 * sizeof(uint32_t), NULL, GL_STREAM_DRAW);
+	glBufferSubData(GL_TEXTURE_BUFFER, 0, texels.size() * sizeof(uint32_t), texels.data());
+	glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
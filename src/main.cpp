@@ -21,11 +21,74 @@ Camera *camera;
 GLboolean MOUSE_VERTICAL_INVERSE = true;
 GLboolean MOUSE_HORIZONTAL_INVERSE = false;
 
+//write the profiler capture and print its summary
+static bool saveProfile(const string &path)
+{
+	if (!Profiler::save(path))
+		return false;
+	Profiler::printSummary(cout);
+	return true;
+}
+
+//usage: ogl_advance [--headless frames] [--output image.ppm] [--record path.txt]
+//	[--profile trace.json] [--trace-gl]
+//	--headless: render a positive number of frames without a window and exit, see headless.h
+//	--output: write the last headless frame into a PPM image
+//	--record: record the camera while flying around, the path can be replayed by
+//		ogl_advance_bench, see cameraPath.h
+//	--profile: time CPU scopes and GPU passes, the capture is saved as a Chrome trace and the
+//		average of every scope is printed at exit, see profiler.h
+//	--trace-gl: count GL calls and redundant state changes, the calls of every headless frame
+//		or of one frame per second are printed, see glTrace.h
 int main(int argc, char *argv[]){
 
-	GLFWwindow *window = initWindow(SCR_WIDTH, SCR_HEIGHT, window_name);
-	if(window == NULL)
-		return -1;
+	unsigned int headless_frames = 0;
+	string output;
+	string record;
+	string profile;
+	bool trace_gl = false;
+	for (int i = 1; i < argc; i ++)
+	{
+		string arg = argv[i];
+		if (arg == "--headless" && i + 1 < argc && atoi(argv[i + 1]) > 0)
+			headless_frames = atoi(argv[++i]);
+		else if (arg == "--output" && i + 1 < argc)
+			output = argv[++i];
+		else if (arg == "--record" && i + 1 < argc)
+			record = argv[++i];
+		else if (arg == "--profile" && i + 1 < argc)
+			profile = argv[++i];
+		else if (arg == "--trace-gl")
+			trace_gl = true;
+		else
+		{
+			cout << "usage: ogl_advance [--headless frames] [--output image.ppm] "
+				"[--record path.txt] [--profile trace.json] [--trace-gl]" << endl;
+			return -1;
+		}
+	}
+
+	GLFWwindow *window = NULL;
+	//declared before the scene, so the context is deleted after it
+	unique_ptr<HeadlessContext> headless;
+	if (headless_frames)
+	{
+		headless.reset(initHeadless(SCR_WIDTH, SCR_HEIGHT));
+		if (!headless)
+			return -1;
+	}
+	else
+	{
+		window = initWindow(SCR_WIDTH, SCR_HEIGHT, window_name);
+		if(window == NULL)
+			return -1;
+	}
+
+	if (trace_gl)
+		GLTrace::install();
+	//assets decoded while the scene is built are profiled as well
+	if (!profile.empty())
+		Profiler::setEnabled(true);
 
 	//configure paths
 	const string curr_dir = string(argv[0]).substr(0, string(argv[0]).find_last_of('/'));
@@ -46,13 +109,11 @@ int main(int argc, char *argv[]){
 	//grass material
 	Material mat_grass(vec3(0), vec3(0), vec3(0), 8.0f);
 	vector<string> grass_tex = {tex_grass, tex_grass, tex_grass};
-	SceneID grasses[5];
+	//all grasses share one plane and are drawn with one draw call
+	SceneID grass = scene.addInstancedPlane(mat_grass, grass_tex);
+	InstancedModel *grasses = scene.getInstancedModel(grass);
 	for (int i = 0; i < 5; i ++)
-	{
-		grasses[i] = scene.addPlane(mat_grass, grass_tex);
-		scene.setModelPos(grasses[i], vec3(-3.0f + i, 0.5f, -2.0f + i));
-		scene.setModelRotate(grasses[i], 90.0f, vec3(1.0f, 0.0f, 0.0f));
-	}
+		grasses->addInstance(vec3(-3.0f + i, 0.5f, -2.0f + i), 90.0f, vec3(1.0f, 0.0f, 0.0f));
 	//ground model
 	Material ground_mat(vec3(0), vec3(0), vec3(0), 8.0f);
 	vector<string> ground_tex = {tex_floor, tex_floor, tex_floor};
@@ -62,11 +123,9 @@ int main(int argc, char *argv[]){
  	//two cubes
 	Material cube_mat(vec3(0), vec3(0), vec3(0), 16.0f);
 	vector<string> cube_tex = {tex_stone, tex_stone, tex_stone};
-	SceneID cube_1 = scene.addCube(cube_mat, cube_tex);
-	scene.setModelPos(cube_1, vec3(0.0, 0.5001, 0.0));
-
-	SceneID cube_2 = scene.addCube(cube_mat, cube_tex);
-	scene.setModelPos(cube_2, vec3(-1.5, 0.5001, -3.0));
+	SceneID cubes = scene.addInstancedCube(cube_mat, cube_tex);
+	scene.getInstancedModel(cubes)->addInstance(vec3(0.0, 0.5001, 0.0));
+	scene.getInstancedModel(cubes)->addInstance(vec3(-1.5, 0.5001, -3.0));
 
 	//window
 	Material window_mat(vec3(0), vec3(0), vec3(0), 32.0f);
@@ -81,24 +140,68 @@ int main(int argc, char *argv[]){
 	SceneID dir_white = scene.addDirLight(vec3(1.0, 1.0, 1.0), vec3(-0.2, -1.0, -0.3),
 		vec3(0.2), vec3(0.5), vec3(0.5));
 
+	//-----------------------headless rendering------------------------------//
+	if (headless)
+	{
+		for (unsigned int i = 0; i < headless_frames; i ++)
+		{
+			Profiler::beginFrame();
+			GLTrace::beginFrame();
+			headless->bind();
+			glClearColor(0, 0, 0, 1.0f);
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+			scene.render();
+			if (trace_gl)
+				GLTrace::printFrame(cout);
+		}
+		glFinish();
+		if (!output.empty() && !headless->saveImage(output))
+			return -1;
+		if (!profile.empty() && !saveProfile(profile))
+			return -1;
+		MaterialRegistry::clear();
+		return 0;
+	}
+
 	//-----------------------resndering loop---------------------------------//
+	//a key is recorded every RECORD_INTERVAL seconds
+	const float RECORD_INTERVAL = 0.5f;
+	CameraPath path;
+	float record_start = glfwGetTime();
+	float trace_printed = record_start;
 	while (!glfwWindowShouldClose(window)){
+		Profiler::beginFrame();
+		GLTrace::beginFrame();
 		processInput(window);
 		//update frame timer
 		current_frame = glfwGetTime();
 		delta_time = current_frame - last_frame;
 		last_frame = current_frame;
+		if (!record.empty() && current_frame - record_start >= path.size() * RECORD_INTERVAL)
+			path.addKey(current_frame - record_start, *camera);
 		//clear last frame
 		glClearColor(0, 0, 0, 1.0f);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
 
 		//draw objects
 		scene.render();
+		if (trace_gl && current_frame - trace_printed >= 1.0f)
+		{
+			GLTrace::printFrame(cout);
+			trace_printed = current_frame;
+		}
 
 		glfwSwapBuffers(window);
 		glfwPollEvents();
 	}
 
+	//GPU times are read before the context is deleted
+	bool profile_saved = profile.empty() || saveProfile(profile);
+	MaterialRegistry::clear();
 	glfwTerminate();
+	if (!record.empty() && !path.save(record))
+		return -1;
+	if (!profile_saved)
+		return -1;
 	return 0;
 }
\ No newline at end of file
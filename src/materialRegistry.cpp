@@ -0,0 +1,136 @@
+#include "../include/materialRegistry.h"
+#include <cstring>
+#include <iostream>
+
+using namespace std;
+
+vector<MaterialRegistry::Entry> MaterialRegistry::materials;
+vector<unsigned int> MaterialRegistry::refs;
+vector<unsigned int> MaterialRegistry::free_ids;
+unordered_map<string, unsigned int> MaterialRegistry::ids;
+unsigned int MaterialRegistry::ubo = 0;
+unsigned int MaterialRegistry::capacity = 0;
+unsigned int MaterialRegistry::stride = 0;
+unsigned int MaterialRegistry::bound = NO_MATERIAL;
+
+unsigned int MaterialRegistry::get(const Material &material, const vector<Texture> &textures)
+{
+	//the entry is compared byte by byte, padding is cleared
+	Entry entry;
+	memset((void*)&entry, 0, sizeof(entry));
+	entry.block.ambient = material.ambient;
+	entry.block.diffuse = material.diffuse;
+	entry.block.specular = material.specular;
+	entry.block.shininess = material.shininess;
+	//each texture goes to the next unit of its type
+	for (unsigned int i = 0; i < textures.size(); i ++)
+	{
+		const string &type = textures[i].type;
+		if (type == "ambient" && entry.block.amb_num < TEXTURE_LIMIT)
+			entry.textures[AMBIENT_TEXTURE_UNIT + entry.block.amb_num++] = textures[i].ID;
+		else if (type == "diffuse" && entry.block.diff_num < TEXTURE_LIMIT)
+			entry.textures[DIFFUSE_TEXTURE_UNIT + entry.block.diff_num++] = textures[i].ID;
+		else if (type == "specular" && entry.block.spec_num < TEXTURE_LIMIT)
+			entry.textures[SPECULAR_TEXTURE_UNIT + entry.block.spec_num++] = textures[i].ID;
+	}
+
+	string key((const char*)&entry, sizeof(entry));
+	auto search = ids.find(key);
+	if (search != ids.end())
+	{
+		refs[search->second]++;
+		return search->second;
+	}
+
+	unsigned int ID;
+	if (!free_ids.empty())
+	{
+		ID = free_ids.back();
+		free_ids.pop_back();
+		materials[ID] = entry;
+		refs[ID] = 1;
+	}
+	else
+	{
+		ID = materials.size();
+		materials.push_back(entry);
+		refs.push_back(1);
+	}
+	ids[key] = ID;
+	upload(ID);
+	return ID;
+}
+
+void MaterialRegistry::release(unsigned int ID)
+{
+	if (ID >= refs.size() || refs[ID] == 0)
+	{
+		cout << "Material ID not found in registry: " << ID << endl;
+		return;
+	}
+	if (--refs[ID] > 0)
+		return;
+	ids.erase(string((const char*)&materials[ID], sizeof(Entry)));
+	free_ids.push_back(ID);
+}
+
+void MaterialRegistry::clear()
+{
+	if (ubo)
+		glDeleteBuffers(1, &ubo);
+	materials.clear();
+	refs.clear();
+	free_ids.clear();
+	ids.clear();
+	ubo = 0;
+	capacity = 0;
+	bound = NO_MATERIAL;
+}
+
+void MaterialRegistry::upload(unsigned int ID)
+{
+	if (!ubo)
+	{
+		//ranges bound to a binding point have to start at a multiple of the alignment
+		GLint alignment;
+		glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+		stride = (sizeof(MaterialBlock) + alignment - 1) / alignment * alignment;
+		glGenBuffers(1, &ubo);
+	}
+	glBindBuffer(GL_UNIFORM_BUFFER, ubo);
+	if (ID < capacity)
+		glBufferSubData(GL_UNIFORM_BUFFER, ID * stride, sizeof(MaterialBlock),
+			&materials[ID].block);
+	else
+	{
+		//the buffer is reallocated, every material is copied again
+		capacity = capacity ? capacity * 2 : 64;
+		vector<unsigned char> data(capacity * stride, 0);
+		for (unsigned int i = 0; i < materials.size(); i ++)
+			memcpy(&data[i * stride], &materials[i].block, sizeof(MaterialBlock));
+		glBufferData(GL_UNIFORM_BUFFER, data.size(), &data[0], GL_STATIC_DRAW);
+		bound = NO_MATERIAL;
+	}
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+void MaterialRegistry::bind(unsigned int ID)
+{
+	if (ID >= materials.size() || refs[ID] == 0)
+		return;
+	const Entry &entry = materials[ID];
+	//textures are bound through GLState, units other passes used are bound again
+	for (unsigned int i = 0; i < 3 * TEXTURE_LIMIT; i ++)
+	{
+		if (entry.textures[i])
+			GLState::bindTexture(i, entry.textures[i]);
+	}
+	//only materials bind this binding point
+	if (ID != bound)
+	{
+		glBindBufferRange(GL_UNIFORM_BUFFER, MATERIAL_BLOCK_BINDING, ubo, ID * stride,
+			sizeof(MaterialBlock));
+		bound = ID;
+	}
+	GLState::materialBound();
+}
@@ -1,22 +1,30 @@
 #include "../include/mesh.h"
+#include "../include/materialRegistry.h"
 using namespace std;
 using namespace glm;
 
 void Mesh::setup()
 {
+	setup(vertices.data(), vertices.size(), indices.data(), indices.size());
+}
+
+void Mesh::setup(const Vertex *vertex, unsigned int vertex_num, const unsigned int *index,
+	unsigned int index_num)
+{
+	index_count = index_num;
 	//generating vao, vbo and ebo
 	glGenVertexArrays(1, &VAO);
 	glGenBuffers(1, &VBO);
 	glGenBuffers(1, &EBO);
 	//setting up VAO
-	glBindVertexArray(VAO);
+	GLState::bindVertexArray(VAO);
 	//setting up VBO
 	glBindBuffer(GL_ARRAY_BUFFER, VBO);
-	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);
+	glBufferData(GL_ARRAY_BUFFER, vertex_num * sizeof(Vertex), vertex, GL_STATIC_DRAW);
 	//setting up EBO
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int),
-		&indices[0], GL_STATIC_DRAW);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, index_num * sizeof(unsigned int),
+		index, GL_STATIC_DRAW);
 
 	//VAO arribute pointers
 	//vertex positions
@@ -32,45 +40,72 @@ void Mesh::setup()
 	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), 
 		(void*)offsetof(Vertex, texCoords));
 
-	glBindVertexArray(0);
+	GLState::bindVertexArray(0);
+	updateMaterial();
+}
+
+void Mesh::calcBounds(const Vertex *vertex, unsigned int vertex_num)
+{
+	bounds.calc(&vertex->position, vertex_num, sizeof(Vertex));
 }
 
-void Mesh::render(Shader &shader)
+void Mesh::setInstanceBuffer(unsigned int instance_vbo)
 {
-	//counters uesd for texture name
-	unsigned int counter_amb = 0;
-	unsigned int counter_diff = 0;
-	unsigned int counter_spec = 0;
-//	unsigned int counter_emis = 0; //this is currently not used
-	for (unsigned int i = 0; i < textures.size(); i ++) 
+	GLState::bindVertexArray(VAO);
+	glBindBuffer(GL_ARRAY_BUFFER, instance_vbo);
+	//a mat4 attribute takes 4 locations, one for each column
+	for (unsigned int i = 0; i < 4; i ++)
 	{
-		glActiveTexture(GL_TEXTURE0 + i); 
-		string name;
-		if(textures[i].type == "ambient")
-			name = "ambient[" + to_string(counter_amb++) + "]";
-		else if(textures[i].type == "diffuse")
-			name = "diffuse[" + to_string(counter_diff++) + "]";
-		else if(textures[i].type == "specular")
-			name = "specular[" + to_string(counter_spec++) + "]";
-		//else if(textures[i].type == emission)
-		//	name = "emission[" + to_string(counter_emis++) + "]";
-		shader.setInt("material." + name, i);
-		glBindTexture(GL_TEXTURE_2D, textures[i].ID);
+		glEnableVertexAttribArray(INSTANCE_ATTRIB + i);
+		glVertexAttribPointer(INSTANCE_ATTRIB + i, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4),
+			(void*)(i * sizeof(glm::vec4)));
+		glVertexAttribDivisor(INSTANCE_ATTRIB + i, 1);
 	}
-	//update texture numbers
-	shader.setInt("material.amb_num", counter_amb);
-	shader.setInt("material.diff_num", counter_diff);
-	shader.setInt("material.spec_num", counter_spec);
-	shader.setVec3("material.ambient", material.ambient);
-	shader.setVec3("material.diffuse", material.diffuse);
-	shader.setVec3("material.specular", material.specular);
-	shader.setFloat("material.shininess", material.shininess);
-	//draw mesh
-	glBindVertexArray(VAO);
-	glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
-	glBindVertexArray(0);
+	GLState::bindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void Mesh::render()
+{
+	bindMaterial();
+	draw();
+}
 
-	glActiveTexture(GL_TEXTURE0);
+void Mesh::renderInstanced(unsigned int instances)
+{
+	bindMaterial();
+	draw(instances);
+}
+
+void Mesh::draw(unsigned int instances)
+{
+	GLState::bindVertexArray(VAO);
+	if (instances)
+		glDrawElementsInstanced(GL_TRIANGLES, index_count, GL_UNSIGNED_INT, 0, instances);
+	else
+		glDrawElements(GL_TRIANGLES, index_count, GL_UNSIGNED_INT, 0);
+	GLState::drawCalled();
+}
+
+void Mesh::bindMaterial()
+{
+	MaterialRegistry::bind(material_id);
+}
+
+void Mesh::updateMaterial()
+{
+	//the new material is found first, so an unchanged material is not removed in between
+	unsigned int previous = material_id;
+	material_id = MaterialRegistry::get(material, textures);
+	if (previous != NO_MATERIAL)
+		MaterialRegistry::release(previous);
+}
+
+void Mesh::releaseMaterial()
+{
+	if (material_id != NO_MATERIAL)
+		MaterialRegistry::release(material_id);
+	material_id = NO_MATERIAL;
 }
 
 std::ostream& operator<< (std::ostream &os, const Mesh &mesh)
@@ -0,0 +1,274 @@
+#include "../include/meshCache.h"
+
+#include <fstream>
+#include <atomic>
+#include <iostream>
+#include <cstring>
+#include <cstdio>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <cstdlib>
+#else
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+const string MeshCache::EXTENSION = ".baked";
+
+static const char BAKED_MAGIC[4] = {'O', 'G', 'L', 'B'};
+//version 2: vertices are transformed by their node in the model
+static const uint32_t BAKED_VERSION = 2;
+//numbers temporary files, so that workers baking the same model don't write into one file
+static atomic<unsigned int> temp_counter(0);
+
+struct BakedHeader {
+	char magic[4];
+	uint32_t version;
+	uint32_t vertex_size;	//sizeof(Vertex) when the file was written
+	uint32_t mesh_num;
+	uint64_t source_size;	//the source file this was baked from
+	int64_t source_time;
+};
+
+struct BakedMeshHeader {
+	uint64_t vertex_offset;
+	uint64_t index_offset;
+	uint64_t texture_offset;
+	uint32_t vertex_num;
+	uint32_t index_num;
+	uint32_t texture_num;
+	float ambient[3];
+	float diffuse[3];
+	float specular[3];
+	float shininess;
+	uint32_t pad;
+};
+
+//round up to 4 bytes
+static uint64_t align4(uint64_t offset)
+{
+	return (offset + 3) & ~uint64_t(3);
+}
+
+bool MeshCache::sourceStamp(const string &source, uint64_t &size, int64_t &time)
+{
+	struct stat info;
+	if (stat(source.c_str(), &info) != 0)
+		return false;
+	size = info.st_size;
+	time = info.st_mtime;
+	return true;
+}
+
+bool MeshCache::open(const string &baked, const string &source)
+{
+	close();
+	uint64_t source_size;
+	int64_t source_time;
+	if (!sourceStamp(source, source_size, source_time))
+		return false;
+
+#ifdef _WIN32
+	//no mapping on windows, read the whole file instead
+	ifstream file(baked, ios::binary | ios::ate);
+	if (!file)
+		return false;
+	size = file.tellg();
+	char *buf = (char*)malloc(size);
+	file.seekg(0);
+	file.read(buf, size);
+	data = buf;
+#else
+	int fd = ::open(baked.c_str(), O_RDONLY);
+	if (fd < 0)
+		return false;
+	struct stat info;
+	if (fstat(fd, &info) != 0 || info.st_size < (off_t)sizeof(BakedHeader))
+	{
+		::close(fd);
+		return false;
+	}
+	size = info.st_size;
+	void *mapped = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd);	//the mapping stays valid after closing the file
+	if (mapped == MAP_FAILED)
+	{
+		size = 0;
+		return false;
+	}
+	data = (const char*)mapped;
+#endif
+
+	//check the header
+	const BakedHeader *header = (const BakedHeader*)data;
+	if (size < sizeof(BakedHeader) || memcmp(header->magic, BAKED_MAGIC, 4) != 0 || 
+		header->version != BAKED_VERSION || header->vertex_size != sizeof(Vertex) ||
+		header->source_size != source_size || header->source_time != source_time ||
+		size < sizeof(BakedHeader) + header->mesh_num * sizeof(BakedMeshHeader))
+	{
+		close();
+		return false;
+	}
+
+	const BakedMeshHeader *mesh_headers = (const BakedMeshHeader*)(data + sizeof(BakedHeader));
+	for (unsigned int i = 0; i < header->mesh_num; i ++)
+	{
+		const BakedMeshHeader &mh = mesh_headers[i];
+		if (mh.vertex_offset + uint64_t(mh.vertex_num) * sizeof(Vertex) > size ||
+			mh.index_offset + uint64_t(mh.index_num) * sizeof(unsigned int) > size)
+		{
+			close();
+			return false;
+		}
+
+		BakedMesh mesh;
+		mesh.vertices = (const Vertex*)(data + mh.vertex_offset);
+		mesh.vertex_num = mh.vertex_num;
+		mesh.indices = (const unsigned int*)(data + mh.index_offset);
+		mesh.index_num = mh.index_num;
+		mesh.material = Material(glm::vec3(mh.ambient[0], mh.ambient[1], mh.ambient[2]),
+			glm::vec3(mh.diffuse[0], mh.diffuse[1], mh.diffuse[2]),
+			glm::vec3(mh.specular[0], mh.specular[1], mh.specular[2]), mh.shininess);
+
+		//texture references are stored as length prefixed strings
+		uint64_t offset = mh.texture_offset;
+		for (unsigned int j = 0; j < mh.texture_num; j ++)
+		{
+			string fields[2];
+			for (int k = 0; k < 2; k ++)
+			{
+				if (offset + sizeof(uint32_t) > size)
+				{
+					close();
+					return false;
+				}
+				uint32_t length;
+				memcpy(&length, data + offset, sizeof(uint32_t));
+				offset += sizeof(uint32_t);
+				if (offset + length > size)
+				{
+					close();
+					return false;
+				}
+				fields[k].assign(data + offset, length);
+				offset = align4(offset + length);
+			}
+			mesh.textures.push_back(Texture(0, fields[0], fields[1]));
+		}
+		meshes.push_back(mesh);
+	}
+	return true;
+}
+
+void MeshCache::close()
+{
+	meshes.clear();
+	if (!data)
+		return;
+#ifdef _WIN32
+	free((void*)data);
+#else
+	munmap((void*)data, size);
+#endif
+	data = NULL;
+	size = 0;
+}
+
+//write a length prefixed string, padded to 4 bytes
+static void writeString(ofstream &file, const string &str)
+{
+	static const char zeros[4] = {0, 0, 0, 0};
+	uint32_t length = str.size();
+	file.write((const char*)&length, sizeof(uint32_t));
+	file.write(str.data(), length);
+	file.write(zeros, align4(length) - length);
+}
+
+bool MeshCache::write(const string &baked, const string &source, const vector<Mesh> &meshes)
+{
+	BakedHeader header;
+	memcpy(header.magic, BAKED_MAGIC, 4);
+	header.version = BAKED_VERSION;
+	header.vertex_size = sizeof(Vertex);
+	header.mesh_num = meshes.size();
+	if (!sourceStamp(source, header.source_size, header.source_time))
+		return false;
+
+	//calculate offsets of every section
+	vector<BakedMeshHeader> mesh_headers(meshes.size());
+	uint64_t offset = sizeof(BakedHeader) + meshes.size() * sizeof(BakedMeshHeader);
+	for (unsigned int i = 0; i < meshes.size(); i ++)
+	{
+		mesh_headers[i].texture_offset = offset;
+		for (unsigned int j = 0; j < meshes[i].textures.size(); j ++)
+		{
+			offset += sizeof(uint32_t) + align4(meshes[i].textures[j].type.size());
+			offset += sizeof(uint32_t) + align4(meshes[i].textures[j].path.size());
+		}
+	}
+	for (unsigned int i = 0; i < meshes.size(); i ++)
+	{
+		mesh_headers[i].vertex_offset = offset;
+		offset += meshes[i].vertices.size() * sizeof(Vertex);
+	}
+	for (unsigned int i = 0; i < meshes.size(); i ++)
+	{
+		mesh_headers[i].index_offset = offset;
+		offset += meshes[i].indices.size() * sizeof(unsigned int);
+	}
+	for (unsigned int i = 0; i < meshes.size(); i ++)
+	{
+		const Material &mat = meshes[i].material;
+		BakedMeshHeader &mh = mesh_headers[i];
+		mh.vertex_num = meshes[i].vertices.size();
+		mh.index_num = meshes[i].indices.size();
+		mh.texture_num = meshes[i].textures.size();
+		for (int k = 0; k < 3; k ++)
+		{
+			mh.ambient[k] = mat.ambient[k];
+			mh.diffuse[k] = mat.diffuse[k];
+			mh.specular[k] = mat.specular[k];
+		}
+		mh.shininess = mat.shininess;
+		mh.pad = 0;
+	}
+
+	//write into a temporary file first, so a half written file is never opened
+	string temp = baked + "." + to_string(temp_counter++) + ".tmp";
+	ofstream file(temp, ios::binary | ios::trunc);
+	if (!file)
+	{
+		cout << "Failed to write baked meshes: " << baked << endl;
+		return false;
+	}
+	file.write((const char*)&header, sizeof(BakedHeader));
+	file.write((const char*)mesh_headers.data(), mesh_headers.size() * sizeof(BakedMeshHeader));
+	for (unsigned int i = 0; i < meshes.size(); i ++)
+	{
+		for (unsigned int j = 0; j < meshes[i].textures.size(); j ++)
+		{
+			writeString(file, meshes[i].textures[j].type);
+			writeString(file, meshes[i].textures[j].path);
+		}
+	}
+	for (unsigned int i = 0; i < meshes.size(); i ++)
+		file.write((const char*)meshes[i].vertices.data(), meshes[i].vertices.size() * sizeof(Vertex));
+	for (unsigned int i = 0; i < meshes.size(); i ++)
+		file.write((const char*)meshes[i].indices.data(), 
+			meshes[i].indices.size() * sizeof(unsigned int));
+	file.close();
+
+#ifdef _WIN32
+	remove(baked.c_str());	//rename doesn't replace existing files on windows
+#endif
+	if (!file || rename(temp.c_str(), baked.c_str()) != 0)
+	{
+		cout << "Failed to write baked meshes: " << baked << endl;
+		remove(temp.c_str());
+		return false;
+	}
+	return true;
+}
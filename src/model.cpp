@@ -6,20 +6,44 @@ using namespace glm;
 
 void Model::render()
 {
-	shader.use();
-	for (unsigned int i = 0; i < meshes.size(); i++)
-		meshes[i].render(shader);
+	shader->use();
+	for (unsigned int i = 0; i < uploaded; i++)
+		meshes[i].render();
 }
 
 void Model::render(Shader &_shader)
 {
 	_shader.use();
-	for (unsigned int i = 0; i < meshes.size(); i ++)
-		meshes[i].render(_shader);
+	for (unsigned int i = 0; i < uploaded; i ++)
+		meshes[i].render();
+}
+
+bool Model::importAsset(const string &path)
+{
+	deferred = true;
+	bool success = loadAiModel(path);
+	deferred = false;
+	return success;
 }
 
-void Model::loadAiModel(const string path)
+unsigned int Model::uploadNext()
 {
+	if (uploaded >= meshes.size())
+		return 0;
+
+	Mesh &mesh = meshes[uploaded++];
+	for (unsigned int i = 0; i < mesh.textures.size(); i ++)
+		mesh.textures[i].ID = loadTexture(mesh.textures[i].path, directory);
+	mesh.setup();
+	return mesh.vertices.size() * sizeof(Vertex) + mesh.indices.size() * sizeof(unsigned int);
+}
+
+bool Model::loadAiModel(const string path)
+{
+	directory = path.substr(0, path.find_last_of('/'));
+	if (loadBaked(path))
+		return true;
+
 	Importer importer;
 	//get scene using assimp
 	const aiScene *scene = importer.ReadFile(path, aiProcess_Triangulate | 
@@ -28,9 +52,47 @@ void Model::loadAiModel(const string path)
 	if(!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
 	{
 		cout << "ERROR::ASSIMP::" << importer.GetErrorString() << endl;
+		return false;
 	}
-	directory = path.substr(0, path.find_last_of('/'));
-	processNode(scene->mRootNode, scene);
+	processNode(scene->mRootNode, scene, mat4(1.0f));
+	//next time the model is loaded from the baked file
+	MeshCache::write(path + MeshCache::EXTENSION, path, meshes);
+	return true;
+}
+
+bool Model::loadBaked(const string &path)
+{
+	MeshCache cache;
+	if (!cache.open(path + MeshCache::EXTENSION, path))
+		return false;
+
+	const vector<BakedMesh> &baked = cache.getMeshes();
+	for (unsigned int i = 0; i < baked.size(); i ++)
+	{
+		const BakedMesh &bm = baked[i];
+		vector<Texture> textures = bm.textures;
+		Material mat = bm.material;
+		if (deferred)
+		{
+			//the mapping is closed before the mesh is uploaded, keep a copy of the data
+			vector<Vertex> vertices(bm.vertices, bm.vertices + bm.vertex_num);
+			vector<unsigned int> indices(bm.indices, bm.indices + bm.index_num);
+			meshes.push_back(Mesh(vertices, indices, textures, mat, false));
+		}
+		else
+		{
+			//upload straight from the mapped file
+			for (unsigned int j = 0; j < textures.size(); j ++)
+				textures[j].ID = loadTexture(textures[j].path, directory);
+			Mesh mesh;
+			mesh.textures = textures;
+			mesh.material = mat;
+			mesh.calcBounds(bm.vertices, bm.vertex_num);
+			mesh.setup(bm.vertices, bm.vertex_num, bm.indices, bm.index_num);
+			meshes.push_back(mesh);
+		}
+	}
+	return true;
 }
 
 void Model::loadManualModel(vector<vec3> &positions, vector<vec3> &normals,
@@ -64,33 +126,46 @@ void Model::loadManualModel(vector<vec3> &positions, vector<vec3> &normals,
 	meshes.push_back(Mesh(vertices, indices, textures, mat));
 }
 
-void Model::processNode(aiNode *root, const aiScene *scene)
+void Model::processNode(aiNode *root, const aiScene *scene, const mat4 &parent)
 {
+	//assimp matrices are row major
+	mat4 local;
+	for (unsigned int r = 0; r < 4; r ++)
+	{
+		for (unsigned int c = 0; c < 4; c ++)
+			local[c][r] = root->mTransformation[r][c];
+	}
+	mat4 transform = parent * local;
+
 	//process all root's meshes
 	for(unsigned int i = 0; i < root->mNumMeshes; i ++)
 	{
 		aiMesh *mesh = scene->mMeshes[root->mMeshes[i]];
-		meshes.push_back(processMesh(mesh, scene));
+		meshes.push_back(processMesh(mesh, scene, transform));
 	}
 	//recursively call this function to it's children
 	for(unsigned int i = 0; i < root->mNumChildren; i ++)
 	{
-		processNode(root->mChildren[i], scene);
+		processNode(root->mChildren[i], scene, transform);
 	}
 }
 
-Mesh Model::processMesh(aiMesh *mesh, const aiScene *scene)
+Mesh Model::processMesh(aiMesh *mesh, const aiScene *scene, const mat4 &transform)
 {
 	vector<Vertex> vertices;
 	vector<unsigned int> indices;
 	vector<Texture> textures;
+	//normals stay perpendicular to surfaces under non uniform scaling
+	mat3 normal_matrix = transpose(inverse(mat3(transform)));
 
 	//process vertices
 	for (unsigned int i = 0; i < mesh->mNumVertices; i ++)
 	{
 		Vertex vertex;
-		vertex.position = vec3(mesh->mVertices[i].x, mesh->mVertices[i].y, mesh->mVertices[i].z);
-		vertex.normal = vec3(mesh->mNormals[i].x, mesh->mNormals[i].y, mesh->mNormals[i].z);
+		vertex.position = vec3(transform * vec4(mesh->mVertices[i].x, mesh->mVertices[i].y, 
+			mesh->mVertices[i].z, 1.0f));
+		vertex.normal = normalize(normal_matrix * 
+			vec3(mesh->mNormals[i].x, mesh->mNormals[i].y, mesh->mNormals[i].z));
 		//check if the vertex has texture coordinates
 		if (mesh->mTextureCoords[0])
 			vertex.texCoords = vec2(mesh->mTextureCoords[0][i].x, mesh->mTextureCoords[0][i].y); 
@@ -135,7 +210,8 @@ Mesh Model::processMesh(aiMesh *mesh, const aiScene *scene)
 					vec3(diffuse.r, diffuse.g, diffuse.b),
 					vec3(specular.r, specular.g, specular.b),
 					shininess};
-	return Mesh(vertices, indices, textures, mat);
+	//deferred meshes are uploaded later by uploadNext()
+	return Mesh(vertices, indices, textures, mat, !deferred);
 }
 
 vector<Texture> Model::loadMaterialTextures(aiMaterial *material, aiTextureType type, 
@@ -147,24 +223,11 @@ vector<Texture> Model::loadMaterialTextures(aiMaterial *material, aiTextureType
 	{
 		aiString str;
 		material->GetTexture(type, i, &str);
-		//check whether the texture is already loaded
-		bool skip = false;
-		for (unsigned int j = 0; j < textures_loaded.size(); j++)//loop all loaded textures
-		{
-			if (strcmp(textures_loaded[j].path.data(), str.C_Str()) == 0)
-			{
-				textures.push_back(textures_loaded[j]);
-				skip = true;
-				break;
-			}
-		}
-		//texture already loaded
-		if(!skip)
-		{
-			Texture texture = {loadTexture(str.C_Str(), directory), type_name, str.C_Str()};
-			textures.push_back(texture);
-			textures_loaded.push_back(texture);
-		}
+		//textures shared between meshes and models are only loaded once by the cache
+		//deferred textures are loaded by uploadNext()
+		unsigned int ID = deferred ? 0 : loadTexture(str.C_Str(), directory);
+		Texture texture = {ID, type_name, str.C_Str()};
+		textures.push_back(texture);
 	}
 	return textures;
 }
@@ -177,51 +240,28 @@ unsigned int Model::loadTexture(const string &path, const string &directory)
 
 unsigned int Model::loadTexture(const string filename)
 {
-	unsigned int ID;
-	glGenTextures(1, &ID);
-
-	int width, height, channels;
-	unsigned char *data = stbi_load(filename.c_str(), &width, &height, &channels, 0);
-	if (data)
-	{
-		GLenum format;
-		if (channels == 1){
-			format = GL_RED;
-			transparent = false;
-		}
-		else if (channels == 3){
-			format = GL_RGB;
-			transparent = false;
-		}
-		else if (channels == 4){
-			format = GL_RGBA;
-			transparent = true;
-		}
+	int channels;
+	unsigned int ID = TextureCache::acquire(filename, &channels);
+	//textures with alpha channel are rendered as transparent
+	transparent = (channels == 4);
+	return ID;
+}
 
-		glBindTexture(GL_TEXTURE_2D, ID);
-		glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-		glGenerateMipmap(GL_TEXTURE_2D);
-		//configure texture parameters
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-		stbi_image_free(data);
-	}
-	else
+void Model::releaseTextures()
+{
+	//textures of meshes not uploaded yet are not loaded
+	for (unsigned int i = 0; i < uploaded; i ++)
 	{
-		cout << "Texture failed to load at path: " << endl << filename << endl;
-		stbi_image_free(data);
+		for (unsigned int j = 0; j < meshes[i].textures.size(); j ++)
+			TextureCache::release(meshes[i].textures[j].ID);
+		meshes[i].releaseMaterial();
 	}
-
-	return ID;
 }
 
-void Model::calcModelView()
+void Model::calcBounds()
 {
-	model = mat4(1.0);	//reset model view matrix
-	model = glm::translate(model, pos);
-	model = glm::rotate(model, radians(rotate_angle), rotate);
-	model = glm::scale(model, scale);
+	bounds = Bounds();
+	for (unsigned int i = 0; i < meshes.size(); i ++)
+		bounds.merge(meshes[i].bounds);
 }
 
@@ -0,0 +1,85 @@
+#include "../include/oitBuffer.h"
+#include <iostream>
+
+using namespace std;
+
+OITBuffer::OITBuffer(unsigned int width, unsigned int height, Shader &composite) :
+	width(width), height(height), target(0), composite(&composite)
+{
+	accum = createColorTarget(GL_RGBA16F, GL_RGBA, width, height);
+	weight = createColorTarget(GL_R16F, GL_RED, width, height);
+
+	glGenRenderbuffers(1, &depth);
+	glBindRenderbuffer(GL_RENDERBUFFER, depth);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	GLint previous;
+	glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previous);
+	glGenFramebuffers(1, &fbo);
+	glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, accum, 0);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, weight, 0);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depth);
+	const GLenum buffers[] = {GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1};
+	glDrawBuffers(2, buffers);
+	complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+	if (!complete)
+		cout << "ERROR::FRAMEBUFFER::OIT_BUFFER_NOT_COMPLETE" << endl;
+	glBindFramebuffer(GL_FRAMEBUFFER, previous);
+
+	glGenVertexArrays(1, &empty_vao);
+
+	//texture units are fixed, set them once
+	composite.use();
+	composite.setInt("accum", 0);
+	composite.setInt("weight", 1);
+}
+
+OITBuffer::~OITBuffer()
+{
+	glDeleteFramebuffers(1, &fbo);
+	glDeleteTextures(1, &accum);
+	glDeleteTextures(1, &weight);
+	GLState::textureDeleted(accum);
+	GLState::textureDeleted(weight);
+	glDeleteRenderbuffers(1, &depth);
+	glDeleteVertexArrays(1, &empty_vao);
+}
+
+void OITBuffer::begin()
+{
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &target);
+	//transparent fragments are still hidden by opaque ones
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, target);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, fbo);
+	glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+	glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+
+	const float clear_accum[] = {0.0f, 0.0f, 0.0f, 1.0f};
+	const float clear_weight[] = {0.0f, 0.0f, 0.0f, 0.0f};
+	glClearBufferfv(GL_COLOR, 0, clear_accum);
+	glClearBufferfv(GL_COLOR, 1, clear_weight);
+
+	glDepthMask(GL_FALSE);
+	glEnable(GL_BLEND);
+	glBlendFuncSeparate(GL_ONE, GL_ONE, GL_ZERO, GL_ONE_MINUS_SRC_ALPHA);
+}
+
+void OITBuffer::end()
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, target);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	//the full screen triangle is not hidden by anything
+	glDisable(GL_DEPTH_TEST);
+
+	composite->use();
+	GLState::bindTexture(0, accum);
+	GLState::bindTexture(1, weight);
+	GLState::bindVertexArray(empty_vao);
+	glDrawArrays(GL_TRIANGLES, 0, 3);
+	GLState::drawCalled();
+
+	glEnable(GL_DEPTH_TEST);
+	glDepthMask(GL_TRUE);
+}
@@ -37,22 +37,19 @@ void PointLight::setAttenuation(float _range){
 	quadra = att_table[(att_table_size - 1) * 4 + 3];
 }
 
-void PointLight::sendShader(Shader &shader, const string &name) const
+void PointLight::fillRecord(LightRecord &record) const
 {
-	string pos(name);
-	string amb(name);
-	string diff(name);
-	string spec(name);
-	string cons(name);
-	string lin(name);
-	string quad(name);
-
-	shader.setVec3(pos.append(".position"), position);
-	shader.setVec3(amb.append(".ambient"), ambient * color);
-	shader.setVec3(diff.append(".diffuse"), diffuse * color);
-	shader.setVec3(spec.append(".specular"), specular * color);
-	shader.setFloat(cons.append(".constant"), constant);
-	shader.setFloat(lin.append(".linear"), linear);
-	shader.setFloat(quad.append(".quadra"), quadra);
-
+	record.position = position;
+	//the cone covers every direction, so the spot intensity is always 1
+	record.direction = vec3(0.0f, 0.0f, -1.0f);
+	record.inner_cutoff = -2.0f;
+	record.outer_cutoff = -3.0f;
+	record.ambient = ambient * color;
+	record.diffuse = diffuse * color;
+	record.specular = specular * color;
+	record.constant = constant;
+	record.linear = linear;
+	record.quadra = quadra;
+	record.range = range;
+	record.pad[0] = record.pad[1] = record.pad[2] = 0.0f;
 }
\ No newline at end of file
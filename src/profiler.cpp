@@ -0,0 +1,219 @@
+#include "../include/profiler.h"
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <chrono>
+#include <mutex>
+#include <map>
+
+using namespace std;
+
+//scopes of one thread, written by the thread and read by the rendering thread
+//head and tail only grow, the slot of an index is index % PROFILE_RING_SIZE
+struct ProfileRing {
+	ProfileEvent events[PROFILE_RING_SIZE];
+	atomic<unsigned int> head;		//next event written by the owner
+	atomic<unsigned int> tail;		//next event read by collectScopes()
+	unsigned int thread;
+	bool render;					//whether the owner is the rendering thread
+
+	ProfileRing(unsigned int thread) : head(0), tail(0), thread(thread), render(false) {}
+};
+
+//rings of every thread that recorded a scope. Rings are never deleted, a thread that exits
+//leaves its last scopes to be collected. The lock is only taken when a thread records its
+//first scope and when rings are read
+static vector<ProfileRing*> rings;
+static mutex rings_mutex;
+//nanoseconds of the steady clock when the profiler was enabled, read by every thread
+static atomic<long long> epoch(0);
+
+static long long steadyNow()
+{
+	return chrono::duration_cast<chrono::nanoseconds>(
+		chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+atomic<bool> Profiler::enabled(false);
+vector<ProfileEvent> Profiler::capture;
+unsigned int Profiler::frames = 0;
+GLuint Profiler::queries[2][MAX_GPU_SCOPES] = {};
+const char *Profiler::gpu_names[2][MAX_GPU_SCOPES];
+unsigned long long Profiler::gpu_starts[2][MAX_GPU_SCOPES];
+unsigned int Profiler::gpu_counts[2] = {0, 0};
+bool Profiler::gpu_active = false;
+
+void Profiler::setEnabled(bool enable)
+{
+	if (enable && !isEnabled())
+	{
+		//scopes recorded before are dropped with the previous capture
+		collectScopes();
+		capture.clear();
+		frames = 0;
+		gpu_counts[0] = gpu_counts[1] = 0;
+		epoch.store(steadyNow(), memory_order_relaxed);
+	}
+	enabled.store(enable, memory_order_relaxed);
+}
+
+unsigned long long Profiler::now()
+{
+	return steadyNow() - epoch.load(memory_order_relaxed);
+}
+
+ProfileRing& Profiler::getRing()
+{
+	static thread_local ProfileRing *ring = NULL;
+	if (!ring)
+	{
+		lock_guard<mutex> lock(rings_mutex);
+		ring = new ProfileRing(rings.size() + 1);
+		rings.push_back(ring);
+	}
+	return *ring;
+}
+
+void Profiler::record(const char *name, unsigned long long start, unsigned long long end)
+{
+	//a scope started before the profiler was enabled has no valid start
+	if (end < start)
+		return;
+	ProfileRing &ring = getRing();
+	unsigned int head = ring.head.load(memory_order_relaxed);
+	//the rendering thread hasn't collected the ring for too long, drop the scope
+	if (head - ring.tail.load(memory_order_acquire) >= PROFILE_RING_SIZE)
+		return;
+	ProfileEvent &event = ring.events[head % PROFILE_RING_SIZE];
+	event.name = name;
+	event.start = start;
+	event.duration = end - start;
+	event.thread = ring.thread;
+	//the event is written before the reader can see it
+	ring.head.store(head + 1, memory_order_release);
+}
+
+void Profiler::collectScopes()
+{
+	lock_guard<mutex> lock(rings_mutex);
+	for (unsigned int i = 0; i < rings.size(); i ++)
+	{
+		ProfileRing &ring = *rings[i];
+		unsigned int tail = ring.tail.load(memory_order_relaxed);
+		unsigned int head = ring.head.load(memory_order_acquire);
+		for (; tail != head; tail ++)
+			capture.push_back(ring.events[tail % PROFILE_RING_SIZE]);
+		//the slots can be written again
+		ring.tail.store(tail, memory_order_release);
+	}
+}
+
+void Profiler::collectGPU(unsigned int set)
+{
+	for (unsigned int i = 0; i < gpu_counts[set]; i ++)
+	{
+		//the query was ended two frames ago, the result is almost always available
+		GLuint64 elapsed = 0;
+		glGetQueryObjectui64v(queries[set][i], GL_QUERY_RESULT, &elapsed);
+		//the GPU has no clock shared with the CPU, a pass is placed where it was submitted
+		ProfileEvent event = {gpu_names[set][i], gpu_starts[set][i], elapsed, GPU_THREAD};
+		capture.push_back(event);
+	}
+	gpu_counts[set] = 0;
+}
+
+void Profiler::beginFrame()
+{
+	if (!isEnabled())
+		return;
+	getRing().render = true;
+	frames++;
+	//the queries of this frame were last used two frames ago
+	collectGPU(frames % 2);
+	collectScopes();
+}
+
+void Profiler::beginGPU(const char *name)
+{
+	if (!isEnabled())
+		return;
+	if (gpu_active)
+	{
+		cout << "ERROR::PROFILER::GPU_SCOPES_NESTED: " << name << endl;
+		return;
+	}
+	unsigned int set = frames % 2;
+	if (gpu_counts[set] == MAX_GPU_SCOPES)
+		return;
+	//queries are created the first time a pass is timed, the GL context is current by then
+	if (!queries[0][0])
+		glGenQueries(2 * MAX_GPU_SCOPES, &queries[0][0]);
+
+	unsigned int index = gpu_counts[set]++;
+	gpu_names[set][index] = name;
+	gpu_starts[set][index] = now();
+	glBeginQuery(GL_TIME_ELAPSED, queries[set][index]);
+	gpu_active = true;
+}
+
+void Profiler::endGPU()
+{
+	//the query is ended even if the profiler was disabled in between
+	if (!gpu_active)
+		return;
+	glEndQuery(GL_TIME_ELAPSED);
+	gpu_active = false;
+}
+
+bool Profiler::save(const string &path)
+{
+	collectScopes();
+	collectGPU(0);
+	collectGPU(1);
+
+	ofstream file(path.c_str());
+	if (!file)
+	{
+		cout << "ERROR::PROFILER::FILE_NOT_SUCCESFULLY_WRITTEN: " << path << endl;
+		return false;
+	}
+	file << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [" << endl;
+	//names of the tracks
+	file << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 0, \"tid\": " << GPU_THREAD
+		<< ", \"args\": {\"name\": \"GPU\"}}";
+	{
+		lock_guard<mutex> lock(rings_mutex);
+		for (unsigned int i = 0; i < rings.size(); i ++)
+			file << "," << endl << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 0, "
+				"\"tid\": " << rings[i]->thread << ", \"args\": {\"name\": \"" <<
+				(rings[i]->render ? "render" : "worker") << "\"}}";
+	}
+	//trace times are microseconds
+	file << fixed << setprecision(3);
+	for (unsigned int i = 0; i < capture.size(); i ++)
+	{
+		const ProfileEvent &event = capture[i];
+		file << "," << endl << "{\"name\": \"" << event.name << "\", \"ph\": \"X\", \"pid\": 0, "
+			"\"tid\": " << event.thread << ", \"ts\": " << event.start / 1000.0 << ", \"dur\": "
+			<< event.duration / 1000.0 << "}";
+	}
+	file << endl << "]}" << endl;
+	return file.good();
+}
+
+void Profiler::printSummary(ostream &out)
+{
+	collectScopes();
+	//GPU and CPU scopes of the same name are listed apart
+	map<string, double> totals;
+	for (unsigned int i = 0; i < capture.size(); i ++)
+	{
+		const ProfileEvent &event = capture[i];
+		string name = string(event.thread == GPU_THREAD ? "gpu " : "cpu ") + event.name;
+		totals[name] += event.duration / 1e6;
+	}
+	unsigned int frame_num = frames ? frames : 1;
+	out << "profile of " << frame_num << " frames, milliseconds per frame:" << endl;
+	for (map<string, double>::iterator it = totals.begin(); it != totals.end(); it ++)
+		out << "\t" << it->first << ": " << it->second / frame_num << endl;
+}
@@ -0,0 +1,123 @@
+#include "../include/renderQueue.h"
+#include <algorithm>
+
+using namespace std;
+using namespace glm;
+
+static const unsigned int PROGRAM_BITS = 10;
+static const unsigned int MATERIAL_BITS = 24;
+static const unsigned int DEPTH_BITS = 28;
+
+uint64_t RenderQueue::makeKey(RENDER_PASS pass, unsigned int program, unsigned int material,
+	float depth)
+{
+	depth = std::min(std::max(depth, 0.0f), 1.0f);
+	uint64_t d = (uint64_t)(depth * ((1u << DEPTH_BITS) - 1));
+	uint64_t p = program & ((1u << PROGRAM_BITS) - 1);
+	uint64_t m = material & ((1u << MATERIAL_BITS) - 1);
+	uint64_t key = (uint64_t)pass << (PROGRAM_BITS + MATERIAL_BITS + DEPTH_BITS);
+
+	if (pass == TRANSPARENT_PASS)
+	{
+		//farthest first so that blending is correct, the sort is stable so ties keep their
+		//order instead of being grouped by state
+		d = ((1u << DEPTH_BITS) - 1) - d;
+		return key | d << (PROGRAM_BITS + MATERIAL_BITS);
+	}
+	//nearest first so that hidden fragments fail the depth test early
+	return key | p << (MATERIAL_BITS + DEPTH_BITS) | m << DEPTH_BITS | d;
+}
+
+void RenderQueue::push(uint64_t key, const RenderItem &item)
+{
+	Entry entry = {key, (unsigned int)items.size()};
+	entries.push_back(entry);
+	items.push_back(item);
+}
+
+void RenderQueue::sort()
+{
+	unsigned int num = entries.size();
+	if (num < 2)
+		return;
+	scratch.resize(num);
+
+	//least significant digit first radix sort, 8 bits per pass
+	//each pass is a stable counting sort, so the whole sort is stable
+	Entry *src = entries.data();
+	Entry *dst = scratch.data();
+	for (unsigned int shift = 0; shift < 64; shift += 8)
+	{
+		unsigned int count[256] = {0};
+		for (unsigned int i = 0; i < num; i ++)
+			count[(src[i].key >> shift) & 0xff]++;
+		//every key has the same digit, nothing to move
+		if (count[(src[0].key >> shift) & 0xff] == num)
+			continue;
+
+		unsigned int offset = 0;
+		for (unsigned int i = 0; i < 256; i ++)
+		{
+			unsigned int c = count[i];
+			count[i] = offset;
+			offset += c;
+		}
+		for (unsigned int i = 0; i < num; i ++)
+			dst[count[(src[i].key >> shift) & 0xff]++] = src[i];
+		std::swap(src, dst);
+	}
+	if (src != entries.data())
+		entries.swap(scratch);
+}
+
+void RenderQueue::submit()
+{
+	submit(0, entries.size());
+}
+
+void RenderQueue::submit(RENDER_PASS pass)
+{
+	//pass is the top bits of the key, so items of a pass are next to each other
+	const unsigned int shift = PROGRAM_BITS + MATERIAL_BITS + DEPTH_BITS;
+	unsigned int begin = 0;
+	while (begin < entries.size() && (entries[begin].key >> shift) < (uint64_t)pass)
+		begin ++;
+	unsigned int end = begin;
+	while (end < entries.size() && (entries[end].key >> shift) == (uint64_t)pass)
+		end ++;
+	submit(begin, end);
+}
+
+void RenderQueue::submit(unsigned int begin, unsigned int end)
+{
+	//model matrix used by the last draw, meshes of one model are usually drawn together
+	const Shader *last_shader = NULL;
+	int last_transform = -1;
+	//material bound by the last draw, other passes may have changed the textures before this
+	//one so the first material is always bound
+	unsigned int last_material = NO_MATERIAL;
+	for (unsigned int i = begin; i < end; i ++)
+	{
+		const RenderItem &item = items[entries[i].index];
+		Shader &shader = *item.shader;
+		shader.use();
+		//materials are shared by programs, samplers of every program use the same units
+		if (item.mesh->material_id != last_material)
+		{
+			item.mesh->bindMaterial();
+			last_material = item.mesh->material_id;
+		}
+		if (item.instances)
+		{
+			item.mesh->draw(item.instances);
+			continue;
+		}
+		if (item.transform != last_transform || &shader != last_shader)
+		{
+			shader.setInt(shader.locations.draw_id, item.transform);
+			last_transform = item.transform;
+			last_shader = &shader;
+		}
+		item.mesh->draw();
+	}
+}
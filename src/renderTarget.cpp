@@ -0,0 +1,15 @@
+#include "../include/renderTarget.h"
+
+unsigned int createColorTarget(GLint internal_format, GLenum format, unsigned int width,
+	unsigned int height)
+{
+	unsigned int ID;
+	glGenTextures(1, &ID);
+	GLState::bindTexture(0, ID);
+	glTexImage2D(GL_TEXTURE_2D, 0, internal_format, width, height, 0, format, GL_FLOAT, NULL);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	return ID;
+}
@@ -5,13 +5,13 @@ using namespace std;
 
 
 
-void Scene::setShader(Shader &shader, mat4 model, mat4 view, mat4 proj)
+//print why an object can't be found by its id
+static void notFound(const char *name, bool stale)
 {
-	shader.use();
-	shader.setMat4("model", model);
-	shader.setMat4("view", view);
-	shader.setMat4("proj", proj);
-	shader.setVec3("viewPos", camera.Position);
+	if (stale)
+		cout << name << " ID is stale, it has been removed" << endl;
+	else
+		cout << name << " ID not found" << endl;
 }
 
 void Scene::render()
@@ -21,35 +21,120 @@ void Scene::render()
 	// glStencilOp(GL_KEEP, GL_REPLACE, GL_REPLACE);
 	// glStencilMask(0x00);
 
-	//render all normal objects
+	ProfileScope render_scope("Scene::render");
+	unsigned long allocs = getAllocCount();
+	stats.draws = 0;
+	stats.culled = 0;
+	stats.instances = 0;
+	GLState::resetChanges();
+
+	//upload textures and models finished loading since the last frame
+	{
+		ProfileScope scope("upload assets");
+		TextureCache::update();
+		updateImports();
+	}
+
+	//lights and camera are shared by all programs, upload them once per frame
+	view = camera.getView();
+	{
+		ProfileScope scope("update lights");
+		updateLights();
+	}
+	updateCamera();
+	frustum = Frustum(getProjMat() * view);
+	//only models moved since the last frame and their descendants are rebuilt
+	{
+		ProfileScope scope("update transforms");
+		moved.clear();
+		model_transforms.update(moved);
+		for (unsigned int i = 0; i < moved.size(); i ++)
+			graph.setLocal(moved[i], model_transforms.getMatrix(moved[i]));
+		stats.transforms_rebuilt = graph.update();
+	}
 
-	//sort all models from farthest to closest to the camera
-	map<float, Model*> sorted;
-	for (auto it = models.begin(); it != models.end(); it ++)
+	//every model is drawn through the render queue. Opaque models are ordered by program and
+	//textures, transparent models are drawn after them from farthest to closest to the camera
+	queue.clear();
+	transforms.clear();
+	oit_draws = 0;
 	{
-		if(it->second.transparent)	//have alpha value
+		ProfileScope scope("queue models");
+		//models are stored contiguously, see slotMap.h
+		for (unsigned int i = 0; i < models.size(); i ++)
 		{
-			float distance = length(camera.Position - it->second.pos);
-			sorted[distance] = &it->second;
-		} 
-		else //doesn't have alpha value
+			if (!isVisible(graph.getWorldBounds(models[i].transform)))
+				continue;
+			queueModel(models[i]);
+			stats.draws++;
+		}
+
+		//instances of an instanced model are not sorted among themselves
+		for (unsigned int i = 0; i < instancedModels.size(); i ++)
 		{
-			Model model = it->second;
-			sendLights(model);
-			setShader(model.shader, model.model, camera.getView(), getProjMat());
-			model.render();
+			InstancedModel &instanced = instancedModels[i];
+			if (!isVisible(instanced.getWorldBounds()))
+				continue;
+			queueInstancedModel(instanced);
+			stats.draws++;
+			stats.instances += instanced.size();
 		}
-		
 	}
 
-	for (auto it = sorted.rbegin(); it != sorted.rend(); it++)
 	{
-		Model *model = it->second;
-		sendLights(*model);
-		//updating view and projection matrices
-		setShader(model->shader, model->model, camera.getView(), getProjMat());
-		model->render();
+		ProfileScope scope("upload transforms");
+		//all model matrices are uploaded at once
+		transform_buffer.upload(transforms);
 	}
+	{
+		ProfileScope scope("sort queue");
+		queue.sort();
+	}
+	//every pass is timed on the CPU and the GPU
+	if (shading == DEFERRED_SHADING)
+	{
+		{
+			ProfileScope scope("g-buffer pass");
+			GPUProfileScope gpu_scope("g-buffer pass");
+			gbuffer->begin();
+			queue.submit(OPAQUE_PASS);
+		}
+		ProfileScope scope("deferred lighting");
+		GPUProfileScope gpu_scope("deferred lighting");
+		gbuffer->end();
+	}
+	else
+	{
+		ProfileScope scope("opaque pass");
+		GPUProfileScope gpu_scope("opaque pass");
+		queue.submit(OPAQUE_PASS);
+	}
+	{
+		ProfileScope scope("transparent pass");
+		GPUProfileScope gpu_scope("transparent pass");
+		queue.submit(TRANSPARENT_PASS);
+	}
+	if (oit_draws)
+	{
+		ProfileScope scope("oit pass");
+		GPUProfileScope gpu_scope("oit pass");
+		oit->begin();
+		queue.submit(OIT_PASS);
+		oit->end();
+	}
+	{
+		//the driver may flush the frame here
+		ProfileScope scope("fence transforms");
+		transform_buffer.fence();
+	}
+
+	const StateChanges &changes = GLState::getChanges();
+	stats.state_changes = changes.total();
+	stats.state_changes_avoided = changes.avoided;
+	stats.draw_calls = changes.draws;
+	stats.uniform_calls = changes.uniforms;
+	stats.material_binds = changes.materials;
+	stats.allocs = getAllocCount() - allocs;
 
 	// //render all outlined objects with their own shaders
 	// //update all stancil values with 1
@@ -86,61 +171,309 @@ void Scene::render()
 }
 
 
-void Scene::sendLights(Model &model)
+void Scene::queueModel(Model &model)
 {
-	int i;
-	model.shader.use();
-	model.shader.setInt("POINT_LIGHTS_NUM", pointLights.size());
-	model.shader.setInt("DIR_LIGHTS_NUM", dirLights.size());
-	model.shader.setInt("SPOT_LIGHTS_NUM", spotLights.size());
+	transforms.push_back(graph.getWorld(model.transform));
+	queueMeshes(model, transforms.size() - 1, 0, 
+		viewDepth(graph.getWorldBounds(model.transform).center));
+}
+
+void Scene::queueInstancedModel(InstancedModel &instanced)
+{
+	instanced.upload();
+	queueMeshes(instanced.model, -1, instanced.size(), 
+		viewDepth(instanced.getWorldBounds().center));
+}
 
-	for(auto it = pointLights.begin(); it != pointLights.end(); it++)
+void Scene::queueMeshes(Model &owner, int transform, unsigned int instances, float depth)
+{
+	//meshes of one model share its depth, sorted transparent meshes keep their order
+	RENDER_PASS pass = OPAQUE_PASS;
+	Shader *shader = owner.shader;
+	if (owner.transparent && transparency == WEIGHTED_OIT)
 	{
-		it->second.sendShader(model.shader, "pointLights[" + to_string(i++) + "]");
+		pass = OIT_PASS;
+		shader = getVariant(oit_shaders, shader, "WEIGHTED_OIT");
+		oit_draws += owner.uploaded;
 	}
+	else if (owner.transparent)
+		pass = TRANSPARENT_PASS;
+	else if (shading == DEFERRED_SHADING)
+		shader = getVariant(gbuffer_shaders, shader, "GBUFFER");
 
-	i = 0;
-	for(auto it = dirLights.begin(); it != dirLights.end(); it++)
+	for (unsigned int i = 0; i < owner.uploaded; i ++)
 	{
-		it->second.sendShader(model.shader, "dirLights[" + to_string(i++) + "]");
+		Mesh &mesh = owner.meshes[i];
+		RenderItem item = {&mesh, shader, transform, instances};
+		queue.push(RenderQueue::makeKey(pass, shader->ID, mesh.material_id, depth),
+			item);
 	}
+}
 
-	i = 0;
-	for(auto it = spotLights.begin(); it != spotLights.end(); it++)
+Shader* Scene::getVariant(unordered_map<const Shader*, Shader*> &variants, Shader *shader,
+	const char *define)
+{
+	auto search = variants.find(shader);
+	if (search != variants.end())
+		return search->second;
+	Shader *variant = ShaderRegistry::variant(*shader, define);
+	variants.insert({shader, variant});
+	return variant;
+}
+
+void Scene::setTransparency(TRANSPARENCY_MODE mode)
+{
+	if (mode == WEIGHTED_OIT && !oit)
 	{
-		it->second.sendShader(model.shader, "spotLights[" + to_string(i++) + "]");
+		Shader *composite = ShaderRegistry::get(vertex_screen, fragment_oit_composite);
+		oit.reset(new OITBuffer(scrWidth, scrHeight, *composite));
 	}
+	if (mode == WEIGHTED_OIT && !oit->valid())
+		return;
+	transparency = mode;
+}
+
+void Scene::setShading(SHADING_MODE mode)
+{
+	if (mode == DEFERRED_SHADING && !gbuffer)
+	{
+		Shader *lighting = ShaderRegistry::get(vertex_screen, fragment_normal, 
+			{"DEFERRED_LIGHTING"});
+		gbuffer.reset(new GBuffer(scrWidth, scrHeight, *lighting));
+	}
+	if (mode == DEFERRED_SHADING && !gbuffer->valid())
+		return;
+	shading = mode;
+}
+
+float Scene::viewDepth(const vec3 &pos)
+{
+	//only z of the view space position is needed, the camera looks at -z
+	float z = view[0][2] * pos.x + view[1][2] * pos.y + view[2][2] * pos.z + view[3][2];
+	return (-z - NEAR_PLANE) / (FAR_PLANE - NEAR_PLANE);
+}
+
+bool Scene::isVisible(const Bounds &bounds)
+{
+	//models still being imported and instanced models without instances have nothing to render
+	if (bounds.empty())
+		return false;
+	if (!culling || frustum.intersects(bounds))
+		return true;
+	stats.culled++;
+	return false;
+}
+
+unsigned int Scene::createUniformBuffer(unsigned int size, unsigned int binding)
+{
+	unsigned int ubo;
+	glGenBuffers(1, &ubo);
+	glBindBuffer(GL_UNIFORM_BUFFER, ubo);
+	glBufferData(GL_UNIFORM_BUFFER, size, NULL, GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	glBindBufferBase(GL_UNIFORM_BUFFER, binding, ubo);
+	return ubo;
+}
+
+void Scene::updateCamera()
+{
+	CameraBlock block;
+	block.view = view;
+	block.proj = getProjMat();
+	block.viewPos = camera.Position;
+	block.pad = 0;
+
+	glBindBuffer(GL_UNIFORM_BUFFER, camera_ubo);
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(CameraBlock), &block);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+void Scene::updateLights()
+{
+	//padding is compared as well, value-initialization sets everything to zero
+	LightsBlock block = LightsBlock();
+
+	int i = 0;
+	for(unsigned int j = 0; j < dirLights.size() && i < LIGHTS_LIMIT; j++)
+		dirLights[j].fillBlock(block.dirLights[i++]);
+	block.dir_num = i;
+
+	//point and spot lights are binned into clusters, there is no limit on them
+	for (unsigned int j = 0; j < spotLights.size(); j ++)
+		block.ambient += spotLights[j].ambient * spotLights[j].color;
+	block.light_num = pointLights.size() + spotLights.size();
+	getProjMat();
+	clusters.fillBlock(block);
+	stats.lights_uploaded = clusters.update(view,
+		pointLights.size() ? &pointLights[0] : NULL, pointLights.size(),
+		spotLights.size() ? &spotLights[0] : NULL, spotLights.size());
+	stats.light_indices = clusters.getIndexCount();
+
+	//lights can be changed through their pointers, so compare the whole block
+	if (lights_valid && memcmp(&block, &lights_block, sizeof(LightsBlock)) == 0)
+		return;
+
+	lights_block = block;
+	lights_valid = true;
+	glBindBuffer(GL_UNIFORM_BUFFER, lights_ubo);
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(LightsBlock), &lights_block);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	stats.lights_uploaded = true;
 }
 
 SceneID Scene::addModel(const string path)
 {
-	Shader shader(vertex_normal, fragment_normal);
-	Model model(path, shader);
-	unsigned int id = count ++;
-	models.insert({id, model});
-	return SceneID(id, MODEL);
+	//all models share the same program
+	Shader *shader = ShaderRegistry::get(vertex_normal, fragment_normal);
+	Model model(path, *shader);
+	return insertModel(model);
+}
+
+SceneID Scene::addModelAsync(const string path)
+{
+	Shader *shader = ShaderRegistry::get(vertex_normal, fragment_normal);
+	//an empty model is added right away, so it can be positioned before it is loaded
+	Model model(*shader);
+	SceneID id = insertModel(model);
+
+	shared_ptr<ModelImport> job(new ModelImport(id, *shader));
+	imports.push_back(job);
+	if (!importer)
+		importer.reset(new ThreadPool());
+	importer->push([job, path]() {
+		ProfileScope scope("import model");
+		bool success = job->model.importAsset(path);
+		job->status.store(success ? UPLOADING : LOAD_FAILED);
+	});
+	return id;
+}
+
+LOAD_STATUS Scene::getModelStatus(SceneID ID, float *progress)
+{
+	Model *model = getModel(ID);
+	if (!model)
+		return LOAD_FAILED;
+
+	LOAD_STATUS status = LOADED;
+	for (unsigned int i = 0; i < imports.size(); i ++)
+	{
+		if (imports[i]->id == ID)
+			status = (LOAD_STATUS)imports[i]->status.load();
+	}
+
+	if (progress)
+	{
+		if (status == LOADED)
+			*progress = 1;
+		else if (status == UPLOADING && !model->meshes.empty())
+			*progress = float(model->uploaded) / model->meshes.size();
+		else
+			*progress = 0;
+	}
+	return status;
+}
+
+void Scene::updateImports()
+{
+	if (imports.empty())
+		return;
+
+	unsigned int bytes = 0;
+	bool uploaded = false;
+	for (unsigned int i = 0; i < imports.size(); i ++)
+	{
+		ModelImport &job = *imports[i];
+		if (job.status.load() != UPLOADING)
+			continue;
+		Model *search = models.get(job.id.handle());
+		if (!search)	//removed before it is loaded
+		{
+			job.status.store(LOADED);
+			continue;
+		}
+
+		Model &model = *search;
+		if (!job.moved)
+		{
+			model.meshes.swap(job.model.meshes);
+			model.directory = job.model.directory;
+			model.uploaded = 0;
+			model.calcBounds();
+			graph.setBounds(model.transform, model.bounds);
+			job.moved = true;
+		}
+		while (model.uploaded < model.meshes.size() && (!uploaded || bytes < import_budget))
+		{
+			bytes += model.uploadNext();
+			uploaded = true;
+		}
+		if (model.uploaded == model.meshes.size())
+			job.status.store(LOADED);
+	}
+
+	//finished imports and failed imports of removed models are not tracked anymore
+	for (unsigned int i = 0; i < imports.size(); )
+	{
+		int status = imports[i]->status.load();
+		if (status == LOADED || (status == LOAD_FAILED && !models.get(imports[i]->id.handle())))
+		{
+			imports[i] = imports.back();
+			imports.pop_back();
+		}
+		else
+			i ++;
+	}
+}
+
+SceneID Scene::insertModel(Model &model)
+{
+	//the scene graph uses the same index as the transform store
+	model.transform = model_transforms.add();
+	graph.add(model.transform);
+	graph.setBounds(model.transform, model.bounds);
+	return SceneID(models.insert(model), MODEL);
 }
 
 SceneID Scene::addPlane(Material &mat, vector<string> &tex_path)
 {
-	Shader shader(vertex_normal, fragment_normal);
-	Model model = loadModel(shader, square_vertices, square_indices, square_vertices_num, 
+	Shader *shader = ShaderRegistry::get(vertex_normal, fragment_normal);
+	Model model = loadModel(*shader, square_vertices, square_indices, square_vertices_num, 
 		square_indices_num, mat, tex_path);
-	//assign id
-	unsigned int id = count ++;
-	models.insert({id, model});
-	return SceneID(id, MODEL);
+	return insertModel(model);
 }
 
 SceneID Scene::addCube(Material &mat, vector<string> &tex_path)
 {
-	Shader shader(vertex_normal, fragment_normal);
-	Model model = loadModel(shader, cube_vertices, cube_indices, cube_vertices_num,
+	Shader *shader = ShaderRegistry::get(vertex_normal, fragment_normal);
+	Model model = loadModel(*shader, cube_vertices, cube_indices, cube_vertices_num,
 		cube_indices_num, mat, tex_path);
-	//assign id
-	unsigned int id = count ++;
-	models.insert({id, model});
-	return SceneID(id, MODEL);
+	return insertModel(model);
+}
+
+SceneID Scene::addInstancedPlane(Material &mat, vector<string> &tex_path)
+{
+	//instanced models read the model matrix from the instance attribute
+	Shader *shader = ShaderRegistry::get(vertex_normal, fragment_normal, {"INSTANCED"});
+	return addInstancedModel(loadModel(*shader, square_vertices, square_indices, 
+		square_vertices_num, square_indices_num, mat, tex_path));
+}
+
+SceneID Scene::addInstancedCube(Material &mat, vector<string> &tex_path)
+{
+	Shader *shader = ShaderRegistry::get(vertex_normal, fragment_normal, {"INSTANCED"});
+	return addInstancedModel(loadModel(*shader, cube_vertices, cube_indices, cube_vertices_num,
+		cube_indices_num, mat, tex_path));
+}
+
+SceneID Scene::addInstancedModel(const string path)
+{
+	Shader *shader = ShaderRegistry::get(vertex_normal, fragment_normal, {"INSTANCED"});
+	return addInstancedModel(Model(path, *shader));
+}
+
+SceneID Scene::addInstancedModel(const Model &model)
+{
+	return SceneID(instancedModels.insert(InstancedModel(model)), INSTANCED_MODEL);
 }
 
 Model Scene::loadModel(Shader &shader, const float vertices[], const unsigned int indices[], 
@@ -187,85 +520,67 @@ Model Scene::loadModel(Shader &shader, const float vertices[], const unsigned in
 SceneID Scene::addSpotLight(vec3 direction, vec3 position, float inner, float outer)
 {
 	SpotLight light(direction, position, inner, outer);
-	unsigned int id = count ++;
-	spotLights.insert({id, light});
-	return SceneID(id, SPOT_LIGHT);
+	return SceneID(spotLights.insert(light), SPOT_LIGHT);
 }
 
 SceneID Scene::addSpotLight(vec3 color, vec3 direction, vec3 position, vec3 ambient, 
 	vec3 diffuse, vec3 specular, float inner, float outer)
 {
 	SpotLight light(color, direction, position, ambient, diffuse, specular, inner, outer);
-	unsigned int id = count ++;
-	spotLights.insert({id, light});
-	return SceneID(id, SPOT_LIGHT);
+	return SceneID(spotLights.insert(light), SPOT_LIGHT);
 }
 
 SceneID Scene::addSpotLight(SpotLight &light)
 {
-	unsigned int id = count ++;
-	spotLights.insert({id, light});
-	return SceneID(id, SPOT_LIGHT);
+	return SceneID(spotLights.insert(light), SPOT_LIGHT);
 }
 
 SceneID Scene::addDirLight(vec3 direction)
 {
 	DirLight light(direction);
-	unsigned int id = count ++;
-	dirLights.insert({id, light});
-	return SceneID(id, DIR_LIGHT);
+	return SceneID(dirLights.insert(light), DIR_LIGHT);
 }
 
 SceneID Scene::addDirLight(vec3 color, vec3 direction, vec3 ambient, vec3 diffuse, vec3 specular)
 {
 	DirLight light(color, direction, ambient, diffuse, specular);
-	unsigned int id = count ++;
-	dirLights.insert({id, light});
-	return SceneID(id, DIR_LIGHT);
+	return SceneID(dirLights.insert(light), DIR_LIGHT);
 }
 
 SceneID Scene::addDirLight(DirLight &light)
 {
-	unsigned int id = count ++;
-	dirLights.insert({id, light});
-	return SceneID(id, DIR_LIGHT);
+	return SceneID(dirLights.insert(light), DIR_LIGHT);
 }
 
 SceneID Scene::addPointLight(vec3 position, float distance)
 {
 	PointLight light(position, distance);
-	unsigned int id = count ++;
-	pointLights.insert({id, light});
-	return SceneID(id, POINT_LIGHT);
+	return SceneID(pointLights.insert(light), POINT_LIGHT);
 }
 
 SceneID Scene::addPointLight(vec3 color, vec3 position, vec3 ambient, vec3 diffuse, 
 	vec3 specular, float distance)
 {
 	PointLight light(color, position, ambient, diffuse, specular, distance);
-	unsigned int id = count ++;
-	pointLights.insert({id, light});
-	return SceneID(id, POINT_LIGHT);
+	return SceneID(pointLights.insert(light), POINT_LIGHT);
 }
 
 SceneID Scene::addPointLight(PointLight &light)
 {
-	unsigned int id = count ++;
-	pointLights.insert({id, light});
-	return SceneID(id, POINT_LIGHT);
+	return SceneID(pointLights.insert(light), POINT_LIGHT);
 }
 
 void Scene::removeSpotLight(SceneID ID)
 {
 	if (ID.type == SPOT_LIGHT)
 	{
-		auto search = spotLights.find(ID.id);
-		if (search != spotLights.end())
+		auto search = spotLights.get(ID.handle());
+		if (search)
 		{
-			spotLights.erase(search);
+			spotLights.remove(ID.handle());
 			return;
 		}
-		cout << "Spot Light ID not found" << endl;
+		notFound("Spot Light", spotLights.stale(ID.handle()));
 		return;
 	} 
 	cout << "Invalid ID: not SpotLight" << endl;
@@ -275,13 +590,13 @@ void Scene::removeDirLight(SceneID ID)
 {
 	if (ID.type == DIR_LIGHT)
 	{
-		auto search = dirLights.find(ID.id);
-		if (search != dirLights.end())
+		auto search = dirLights.get(ID.handle());
+		if (search)
 		{
-			dirLights.erase(search);
+			dirLights.remove(ID.handle());
 			return;
 		}
-		cout << "Directional Light ID not found" << endl;
+		notFound("Directional Light", dirLights.stale(ID.handle()));
 		return;
 	}
 	cout << "Invalid ID: not DirLight" << endl;
@@ -291,13 +606,13 @@ void Scene::removePointLight(SceneID ID)
 {
 	if (ID.type == POINT_LIGHT)
 	{
-		auto search = pointLights.find(ID.id);
-		if (search != pointLights.end())
+		auto search = pointLights.get(ID.handle());
+		if (search)
 		{
-			pointLights.erase(search);
+			pointLights.remove(ID.handle());
 			return;
 		}
-		cout << "Point Light ID not found" << endl;
+		notFound("Point Light", pointLights.stale(ID.handle()));
 		return;
 	}
 	cout << "Invalid ID: not PointLight" << endl;
@@ -307,26 +622,47 @@ void Scene::removeModel(SceneID ID)
 {
 	if (ID.type == MODEL)
 	{
-		auto search = models.find(ID.id);
-		if (search != models.end())
+		auto search = models.get(ID.handle());
+		if (search)
 		{
-			models.erase(search);
+			search->releaseTextures();
+			graph.remove(search->transform);
+			model_transforms.remove(search->transform);
+			models.remove(ID.handle());
 			return;
 		}
-		cout << "Model ID not found" << endl;
+		notFound("Model", models.stale(ID.handle()));
 		return;
 	}
 	cout << "Invalid ID: not MODEL" << endl;
 }
 
+void Scene::removeInstancedModel(SceneID ID)
+{
+	if (ID.type == INSTANCED_MODEL)
+	{
+		auto search = instancedModels.get(ID.handle());
+		if (search)
+		{
+			search->model.releaseTextures();
+			search->releaseBuffer();
+			instancedModels.remove(ID.handle());
+			return;
+		}
+		notFound("Instanced Model", instancedModels.stale(ID.handle()));
+		return;
+	}
+	cout << "Invalid ID: not INSTANCED_MODEL" << endl;
+}
+
 SpotLight* Scene::getSpotLight(SceneID ID)
 {
 	if (ID.type == SPOT_LIGHT)
 	{
-		auto search = spotLights.find(ID.id);
-		if (search != spotLights.end())
-			return &(search->second);
-		cout << "Spot Light ID not found" << endl;
+		auto search = spotLights.get(ID.handle());
+		if (search)
+			return search;
+		notFound("Spot Light", spotLights.stale(ID.handle()));
 		return NULL;
 	}
 	cout << "Invalid ID: not SpotLight" << endl;
@@ -337,10 +673,10 @@ DirLight* Scene::getDirLight(SceneID ID)
 {
 	if(ID.type == DIR_LIGHT)
 	{
-		auto search = dirLights.find(ID.id);
-		if (search != dirLights.end())
-			return &(search->second);
-		cout << "Directional Light ID not found" << endl;
+		auto search = dirLights.get(ID.handle());
+		if (search)
+			return search;
+		notFound("Directional Light", dirLights.stale(ID.handle()));
 		return NULL;
 	}
 	cout << "Invalid ID: not DirLight" << endl;
@@ -351,10 +687,10 @@ PointLight* Scene::getPointLight(SceneID ID)
 {
 	if(ID.type == POINT_LIGHT)
 	{
-		auto search = pointLights.find(ID.id);
-		if(search != pointLights.end())
-			return &(search->second);
-		cout << "Point Light ID not found" << endl;
+		auto search = pointLights.get(ID.handle());
+		if(search)
+			return search;
+		notFound("Point Light", pointLights.stale(ID.handle()));
 		return NULL;
 	}
 	cout << "Invalid ID: not Point Light";
@@ -365,29 +701,47 @@ Model* Scene::getModel(SceneID ID)
 {
 	if(ID.type == MODEL)
 	{
-		auto search = models.find(ID.id);
-		if(search != models.end())
-			return &(search->second);
-		cout << "Model ID not found" << endl;
+		auto search = models.get(ID.handle());
+		if(search)
+			return search;
+		notFound("Model", models.stale(ID.handle()));
 		return NULL;
 	}
 	cout << "Invalid ID: not Model" << endl;
 	return NULL;
 }
 
+InstancedModel* Scene::getInstancedModel(SceneID ID)
+{
+	if(ID.type == INSTANCED_MODEL)
+	{
+		auto search = instancedModels.get(ID.handle());
+		if(search)
+			return search;
+		notFound("Instanced Model", instancedModels.stale(ID.handle()));
+		return NULL;
+	}
+	cout << "Invalid ID: not Instanced Model" << endl;
+	return NULL;
+}
+
 Camera* Scene::getCamera()
 {
 	return &camera;
 }
 
-mat4 Scene::getProjMat()
+const mat4& Scene::getProjMat()
 {
-	mat4 proj;
+	if (proj_fov == camera.getFOV())
+		return proj;
+
+	proj_fov = camera.getFOV();
 	if (perspec)
-		proj = perspective(radians(camera.getFOV()), float(scrWidth)/float(scrHeight),
-			0.1f, 100.0f);
+		proj = perspective(radians(proj_fov), float(scrWidth)/float(scrHeight),
+			NEAR_PLANE, FAR_PLANE);
 	else
-		proj = ortho(0.0f, float(scrWidth), 0.0f, float(scrHeight), 0.1f, 100.0f);
+		proj = ortho(0.0f, float(scrWidth), 0.0f, float(scrHeight), NEAR_PLANE, FAR_PLANE);
+	clusters.setProjection(proj, NEAR_PLANE, FAR_PLANE, scrWidth, scrHeight);
 
 	return proj;
 }
@@ -397,14 +751,13 @@ void Scene::setModelPos(SceneID id, vec3 pos)
 	if(id.type == MODEL)
 	{
 		//searching model
-		auto search = models.find(id.id);
-		if(search != models.end())
+		auto search = models.get(id.handle());
+		if(search)
 		{
-			search->second.pos = pos;
-			search->second.calcModelView();
+			model_transforms.setPosition(search->transform, pos);
 			return;
 		}
-		cout << "Model ID not found" << endl;
+		notFound("Model", models.stale(id.handle()));
 		return;
 	}
 	cout << "Invalid ID: not MODEL";
@@ -415,15 +768,13 @@ void Scene::setModelRotate(SceneID id, float angle, vec3 rotate)
 	if(id.type == MODEL)
 	{
 		//searching model
-		auto search = models.find(id.id);
-		if(search != models.end())
+		auto search = models.get(id.handle());
+		if(search)
 		{
-			search->second.rotate = rotate;
-			search->second.rotate_angle = angle;
-			search->second.calcModelView();
+			model_transforms.setRotation(search->transform, angle, rotate);
 			return;
 		}
-		cout << "Model ID not found" << endl;
+		notFound("Model", models.stale(id.handle()));
 		return;
 	}
 	cout << "Invalid ID: not MODEL";
@@ -434,15 +785,40 @@ void Scene::setModelScale(SceneID id, vec3 scale)
 	if(id.type == MODEL)
 	{
 		//searching model
-		auto search = models.find(id.id);
-		if(search != models.end())
+		auto search = models.get(id.handle());
+		if(search)
 		{
-			search->second.scale = scale;
-			search->second.calcModelView();
+			model_transforms.setScale(search->transform, scale);
 			return;
 		}
-		cout << "Model ID not found" << endl;
+		notFound("Model", models.stale(id.handle()));
 		return;
 	}
 	cout << "Invalid ID: not MODEL";
 }
+
+void Scene::setModelParent(SceneID id, SceneID parent_id)
+{
+	if (id.type != MODEL)
+	{
+		cout << "Invalid ID: not MODEL" << endl;
+		return;
+	}
+	auto search = models.get(id.handle());
+	if (!search)
+	{
+		notFound("Model", models.stale(id.handle()));
+		return;
+	}
+
+	int parent = -1;
+	if (parent_id.type != INVALID)
+	{
+		Model *parent_model = getModel(parent_id);
+		if (!parent_model)
+			return;
+		parent = parent_model->transform;
+	}
+	if (!graph.setParent(search->transform, parent))
+		cout << "ERROR::SCENE::MODEL_PARENT_IS_DESCENDANT" << endl;
+}
@@ -0,0 +1,203 @@
+#include "../include/sceneGraph.h"
+#include <cstring>
+
+using namespace std;
+using namespace glm;
+
+//reorder an array, element i of the result is element order[i] of the array
+template <typename T>
+static void permute(vector<T> &array, const vector<unsigned int> &order)
+{
+	vector<T> result;
+	result.reserve(array.size());
+	for (unsigned int i = 0; i < order.size(); i ++)
+		result.push_back(array[order[i]]);
+	array.swap(result);
+}
+
+void SceneGraph::add(unsigned int handle)
+{
+	if (handle >= positions.size())
+		positions.resize(handle + 1, -1);
+	positions[handle] = handles.size();
+	handles.push_back(handle);
+	parents.push_back(-1);
+	subtree.push_back(1);
+	dirty.push_back(0);
+	local.push_back(mat4(1.0f));
+	world.push_back(mat4(1.0f));
+	local_bounds.push_back(Bounds());
+	world_bounds.push_back(Bounds());
+	markDirty(handles.size() - 1);
+}
+
+void SceneGraph::remove(unsigned int handle)
+{
+	unsigned int position = positions[handle];
+	int parent = parents[position];
+	unsigned int end = position + subtree[position];
+	growAncestors(parent, -1);
+
+	//children are placed under the parent, the subtree stays contiguous
+	for (unsigned int i = position + 1; i < end; i ++)
+	{
+		if (parents[i] == (int)position)
+		{
+			parents[i] = parent;
+			markDirty(i);
+		}
+	}
+
+	handles.erase(handles.begin() + position);
+	parents.erase(parents.begin() + position);
+	subtree.erase(subtree.begin() + position);
+	dirty.erase(dirty.begin() + position);
+	local.erase(local.begin() + position);
+	world.erase(world.begin() + position);
+	local_bounds.erase(local_bounds.begin() + position);
+	world_bounds.erase(world_bounds.begin() + position);
+
+	positions[handle] = -1;
+	for (unsigned int i = position; i < handles.size(); i ++)
+	{
+		positions[handles[i]] = i;
+		if (parents[i] > (int)position)
+			parents[i]--;
+	}
+	if (first_dirty > position)
+		first_dirty = position;
+}
+
+bool SceneGraph::setParent(unsigned int handle, int parent)
+{
+	unsigned int position = positions[handle];
+	unsigned int size = subtree[position];
+	int parent_position = parent < 0 ? -1 : positions[parent];
+	//a node can't be attached inside its own subtree
+	if (parent_position >= (int)position && parent_position < (int)(position + size))
+		return false;
+	if (parent_position == parents[position])
+		return true;
+
+	growAncestors(parents[position], -(int)size);
+	//the subtree is placed after the last descendant of the new parent, positions are counted
+	//without the subtree
+	unsigned int target = handles.size() - size;
+	if (parent_position >= 0)
+	{
+		unsigned int start = parent_position < (int)position ?
+			parent_position : parent_position - size;
+		target = start + subtree[parent_position];
+	}
+	moveSubtree(position, target);
+
+	position = positions[handle];
+	parents[position] = parent < 0 ? -1 : positions[parent];
+	growAncestors(parents[position], size);
+	markDirty(position);
+	return true;
+}
+
+int SceneGraph::getParent(unsigned int handle) const
+{
+	int parent = parents[positions[handle]];
+	return parent < 0 ? -1 : handles[parent];
+}
+
+void SceneGraph::setLocal(unsigned int handle, const mat4 &matrix)
+{
+	unsigned int position = positions[handle];
+	local[position] = matrix;
+	markDirty(position);
+}
+
+void SceneGraph::setBounds(unsigned int handle, const Bounds &bounds)
+{
+	unsigned int position = positions[handle];
+	local_bounds[position] = bounds;
+	markDirty(position);
+}
+
+unsigned int SceneGraph::update()
+{
+	unsigned int updated = 0;
+	unsigned int num = handles.size();
+	//parents come first, a change is passed down before the children are visited
+	for (unsigned int i = first_dirty; i < num; i ++)
+	{
+		int parent = parents[i];
+		if (parent >= 0 && dirty[parent])
+			dirty[i] = 1;
+		if (!dirty[i])
+			continue;
+		world[i] = parent >= 0 ? world[parent] * local[i] : local[i];
+		world_bounds[i] = local_bounds[i].transform(world[i]);
+		updated++;
+	}
+	if (first_dirty < num)
+		memset(&dirty[first_dirty], 0, num - first_dirty);
+	first_dirty = num;
+	return updated;
+}
+
+void SceneGraph::markDirty(unsigned int position)
+{
+	dirty[position] = 1;
+	if (position < first_dirty)
+		first_dirty = position;
+}
+
+void SceneGraph::moveSubtree(unsigned int position, unsigned int target)
+{
+	unsigned int size = subtree[position];
+	unsigned int num = handles.size();
+	vector<unsigned int> order;
+	order.reserve(num);
+	for (unsigned int i = 0; i < num; i ++)
+	{
+		if (order.size() == target)
+		{
+			for (unsigned int j = position; j < position + size; j ++)
+				order.push_back(j);
+		}
+		if (i < position || i >= position + size)
+			order.push_back(i);
+	}
+	if (order.size() == target)
+	{
+		for (unsigned int j = position; j < position + size; j ++)
+			order.push_back(j);
+	}
+
+	//new position of every node
+	vector<int> moved(num);
+	for (unsigned int i = 0; i < num; i ++)
+		moved[order[i]] = i;
+
+	permute(handles, order);
+	permute(parents, order);
+	permute(subtree, order);
+	permute(dirty, order);
+	permute(local, order);
+	permute(world, order);
+	permute(local_bounds, order);
+	permute(world_bounds, order);
+	for (unsigned int i = 0; i < num; i ++)
+	{
+		if (parents[i] >= 0)
+			parents[i] = moved[parents[i]];
+		positions[handles[i]] = i;
+	}
+	unsigned int first = position < target ? position : target;
+	if (first_dirty > first)
+		first_dirty = first;
+}
+
+void SceneGraph::growAncestors(int position, int count)
+{
+	while (position >= 0)
+	{
+		subtree[position] += count;
+		position = parents[position];
+	}
+}
@@ -2,16 +2,23 @@
 #include "../include/shader.h"
 
 //use this shader program
+//redundant program switching is skipped by GLState
 void Shader::use(){
-	glUseProgram(ID);
+	GLState::useProgram(ID);
+}
+
+void Shader::useNone(){
+	GLState::useProgram(0);
 }
 
 
 //constructor
-Shader::Shader(const std::string &vertexPath, const std::string &fragmentPath)
+Shader::Shader(const std::string &vertexPath, const std::string &fragmentPath,
+	const std::vector<std::string> &_defines)
 {
 	vertex = vertexPath;
 	fragment = fragmentPath;
+	defines = _defines;
 	setup(vertex, fragment);
 }
 
@@ -44,6 +51,9 @@ void Shader::setup(const std::string &vertexPath, const std::string &fragmentPat
 		std::cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ: " << e.what() << std::endl;
 	}
 
+	addDefines(vertexCode);
+	addDefines(fragmentCode);
+
 	const char* vShaderCode = vertexCode.c_str();
 	const char* fShaderCode = fragmentCode.c_str();
 
@@ -67,6 +77,7 @@ void Shader::setup(const std::string &vertexPath, const std::string &fragmentPat
 	glAttachShader(ID, fragment);
 	glLinkProgram(ID);
 	checkLinkSuccess(ID);
+	loadUniforms();
 
 	//delete the shaders as they're linked into the shader program
 	glDeleteShader(vertex);
@@ -96,4 +107,98 @@ void Shader::checkLinkSuccess(unsigned int ID){
 		std::cout << "Shader Program Linking Error\n" << infoLog << std::endl;
 		return;
 	}
+}
+
+void Shader::bindUniformBlock(const std::string &name, unsigned int binding)
+{
+	unsigned int index = glGetUniformBlockIndex(ID, name.c_str());
+	if (index != GL_INVALID_INDEX)
+		glUniformBlockBinding(ID, index, binding);
+}
+
+void Shader::addDefines(std::string &code)
+{
+	if (defines.empty())
+		return;
+	std::string lines;
+	for (unsigned int i = 0; i < defines.size(); i ++)
+		lines += "#define " + defines[i] + "\n";
+	//#version must be the first line of a shader
+	size_t pos = 0;
+	if (code.compare(0, 8, "#version") == 0)
+	{
+		pos = code.find('\n');
+		pos = (pos == std::string::npos) ? code.size() : pos + 1;
+	}
+	code.insert(pos, lines);
+}
+
+void Shader::loadUniforms()
+{
+	uniforms.clear();
+	int uniform_num = 0, max_length = 0;
+	glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &uniform_num);
+	glGetProgramiv(ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &max_length);
+
+	std::vector<char> name_buf(max_length + 1);
+	for (int i = 0; i < uniform_num; i ++)
+	{
+		GLsizei length;
+		GLint size;
+		GLenum type;
+		glGetActiveUniform(ID, i, name_buf.size(), &length, &size, &type, &name_buf[0]);
+		std::string name(&name_buf[0], length);
+		int location = glGetUniformLocation(ID, name.c_str());
+		if (location < 0)	//uniforms inside uniform blocks don't have a location
+			continue;
+		uniforms[name] = location;
+
+		//arrays of basic types are reported only once as "name[0]"
+		//add the array name and all other elements into the table
+		if (length > 3 && name.compare(length - 3, 3, "[0]") == 0)
+		{
+			std::string base = name.substr(0, length - 3);
+			uniforms[base] = location;
+			for (int j = 1; j < size; j ++)
+			{
+				std::string element = base + "[" + std::to_string(j) + "]";
+				uniforms[element] = glGetUniformLocation(ID, element.c_str());
+			}
+		}
+	}
+
+	//bind shared uniform blocks
+	bindUniformBlock("Lights", LIGHTS_BLOCK_BINDING);
+	bindUniformBlock("Camera", CAMERA_BLOCK_BINDING);
+	bindUniformBlock("MaterialBlock", MATERIAL_BLOCK_BINDING);
+
+	//the transform buffer is always bound to the same unit
+	if (getUniform("transforms") != -1)
+	{
+		use();
+		setInt("transforms", TRANSFORMS_TEXTURE_UNIT);
+	}
+	if (getUniform("clusters") != -1)
+	{
+		use();
+		setInt("clusters", LIGHTS_TEXTURE_UNIT);
+	}
+
+	//material textures are always bound to the same units, see MaterialRegistry
+	if (getUniform("tex_ambient") != -1 || getUniform("tex_diffuse") != -1 ||
+		getUniform("tex_specular") != -1)
+	{
+		use();
+		for (int i = 0; i < TEXTURE_LIMIT; i ++)
+		{
+			std::string index = "[" + std::to_string(i) + "]";
+			setInt("tex_ambient" + index, AMBIENT_TEXTURE_UNIT + i);
+			setInt("tex_diffuse" + index, DIFFUSE_TEXTURE_UNIT + i);
+			setInt("tex_specular" + index, SPECULAR_TEXTURE_UNIT + i);
+		}
+	}
+
+	//resolve locations of uniforms set on every draw
+	locations.model = getUniform("model");
+	locations.draw_id = getUniform("drawID");
 }
\ No newline at end of file
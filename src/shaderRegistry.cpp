@@ -0,0 +1,48 @@
+#include "../include/shaderRegistry.h"
+
+using namespace std;
+
+unordered_map<string, Shader> ShaderRegistry::programs;
+
+Shader* ShaderRegistry::get(const string &vertexPath, const string &fragmentPath,
+	const vector<string> &defines)
+{
+	string key = makeKey(vertexPath, fragmentPath, defines);
+	auto search = programs.find(key);
+	if (search != programs.end())
+		return &(search->second);
+
+	//elements of an unordered_map are never moved by rehashing
+	auto result = programs.insert({key, Shader(vertexPath, fragmentPath, defines)});
+	return &(result.first->second);
+}
+
+Shader* ShaderRegistry::variant(const Shader &shader, const string &define)
+{
+	vector<string> defines = shader.getDefines();
+	for (unsigned int i = 0; i < defines.size(); i ++)
+	{
+		if (defines[i] == define)
+			return get(shader.getVertexPath(), shader.getFragmentPath(), defines);
+	}
+	defines.push_back(define);
+	return get(shader.getVertexPath(), shader.getFragmentPath(), defines);
+}
+
+void ShaderRegistry::clear()
+{
+	Shader::useNone();
+	for (auto it = programs.begin(); it != programs.end(); it ++)
+		glDeleteProgram(it->second.ID);
+	programs.clear();
+}
+
+string ShaderRegistry::makeKey(const string &vertexPath, const string &fragmentPath,
+	const vector<string> &defines)
+{
+	//'\n' can not appear in a path or a define
+	string key = vertexPath + '\n' + fragmentPath;
+	for (unsigned int i = 0; i < defines.size(); i ++)
+		key += '\n' + defines[i];
+	return key;
+}
@@ -1,23 +1,23 @@
 #include "../include/spotLight.h"
+#include <cmath>
 
 using namespace glm;
 using namespace std;
 
-void SpotLight::sendShader(Shader &shader, const string &name) const
+void SpotLight::fillRecord(LightRecord &record) const
 {
-	string dir(name);
-	string pos(name);
-	string amb(name);
-	string diff(name);
-	string spec(name);
-	string inner(name);
-	string outer(name);
-
-	shader.setVec3(dir.append(".direction"), direction);
-	shader.setVec3(pos.append(".position"), position);
-	shader.setVec3(amb.append(".ambient"), ambient * color);
-	shader.setVec3(diff.append(".diffuse"), diffuse * color);
-	shader.setVec3(spec.append(".specular"), specular * color);
-	shader.setFloat(inner.append(".inner_cutoff"), cos(radians(inner_cutoff)));
-	shader.setFloat(outer.append(".outer_cutoff"), cos(radians(outer_cutoff)));
+	record.direction = direction;
+	record.position = position;
+	record.ambient = vec3(0.0f);
+	record.diffuse = diffuse * color;
+	record.specular = specular * color;
+	record.inner_cutoff = cos(radians(inner_cutoff));
+	record.outer_cutoff = cos(radians(outer_cutoff));
+	//no attenuation
+	record.constant = 1.0f;
+	record.linear = 0.0f;
+	record.quadra = 0.0f;
+	//the cone is not bounded, see LightClusters::update()
+	record.range = INFINITY;
+	record.pad[0] = record.pad[1] = record.pad[2] = 0.0f;
 }
\ No newline at end of file
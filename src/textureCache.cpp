@@ -0,0 +1,225 @@
+#include "../include/textureCache.h"
+#include "stb_image.h"
+#include "glState.h"
+
+#include "threadPool.h"
+#include "profiler.h"
+
+#include <iostream>
+#include <climits>
+#include <cstdlib>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <memory>
+
+using namespace std;
+
+unordered_map<string, TextureCache::Entry> TextureCache::textures;
+unordered_map<unsigned int, string> TextureCache::paths;
+unsigned int TextureCache::hit_count = 0;
+unsigned int TextureCache::miss_count = 0;
+unsigned int TextureCache::pending_count = 0;
+unsigned int TextureCache::upload_budget = 16 * 1024 * 1024;
+bool TextureCache::decode_async = true;
+
+//an image decoded by a worker thread, waiting to be uploaded
+struct DecodedImage {
+	unsigned int ID;
+	string key;
+	int width, height, channels;	//0 if decoding failed
+	unsigned char *data;	//NULL if decoding failed
+};
+
+//decoded images are handed to the rendering thread through this queue
+static mutex decoded_mutex;
+static deque<DecodedImage> decoded;
+//the pool is created on first use. It is declared after the list above, so it is destroyed 
+//(and its workers joined) before the list
+static unique_ptr<ThreadPool> decoder;
+
+//color of textures whose image is not uploaded yet
+static const unsigned char placeholder[4] = {128, 128, 128, 255};
+
+unsigned int TextureCache::acquire(const string &path, int *channels)
+{
+	string key = canonicalPath(path);
+	auto search = textures.find(key);
+	if (search != textures.end())
+	{
+		hit_count++;
+		search->second.refs++;
+		if (channels)
+			*channels = search->second.channels;
+		return search->second.ID;
+	}
+
+	miss_count++;
+	Entry entry;
+	entry.ID = decode_async ? loadAsync(path, key, entry.channels) : load(path, entry.channels);
+	entry.refs = 1;
+	entry.pending = decode_async && entry.channels != 0;
+	if (entry.pending)
+		pending_count++;
+	textures.insert({key, entry});
+	paths.insert({entry.ID, key});
+	if (channels)
+		*channels = entry.channels;
+	return entry.ID;
+}
+
+void TextureCache::release(unsigned int ID)
+{
+	auto path = paths.find(ID);
+	if (path == paths.end())
+	{
+		cout << "Texture ID not found in cache: " << ID << endl;
+		return;
+	}
+	auto search = textures.find(path->second);
+	if (--search->second.refs > 0)
+		return;
+
+	//the decoded image of a pending texture is dropped by update()
+	if (search->second.pending)
+		pending_count--;
+
+	glDeleteTextures(1, &ID);
+	GLState::textureDeleted(ID);
+	textures.erase(search);
+	paths.erase(path);
+}
+
+string TextureCache::canonicalPath(const string &path)
+{
+#ifdef _WIN32
+	char buf[_MAX_PATH];
+	if (_fullpath(buf, path.c_str(), _MAX_PATH))
+		return string(buf);
+#else
+	char buf[PATH_MAX];
+	if (realpath(path.c_str(), buf))
+		return string(buf);
+#endif
+	//file doesn't exist, it will fail to load anyway
+	return path;
+}
+
+unsigned int TextureCache::load(const string &filename, int &channels)
+{
+	unsigned int ID;
+	glGenTextures(1, &ID);
+
+	int width, height;
+	channels = 0;
+	unsigned char *data = stbi_load(filename.c_str(), &width, &height, &channels, 0);
+	if (data)
+	{
+		upload(ID, data, width, height, channels);
+		stbi_image_free(data);
+	}
+	else
+	{
+		cout << "Texture failed to load at path: " << endl << filename << endl;
+		channels = 0;
+	}
+
+	return ID;
+}
+
+unsigned int TextureCache::loadAsync(const string &filename, const string &key, int &channels)
+{
+	unsigned int ID;
+	glGenTextures(1, &ID);
+	upload(ID, placeholder, 1, 1, 4);
+
+	//only read the header here, transparency of models depends on the number of channels
+	int width, height;
+	if (!stbi_info(filename.c_str(), &width, &height, &channels))
+	{
+		cout << "Texture failed to load at path: " << endl << filename << endl;
+		channels = 0;
+		return ID;
+	}
+
+	if (!decoder)
+		decoder.reset(new ThreadPool());
+	decoder->push([ID, key, filename]() {
+		ProfileScope scope("decode texture");
+		//value-initialized, stbi_load doesn't write the size if it fails
+		DecodedImage image = DecodedImage();
+		image.ID = ID;
+		image.key = key;
+		image.data = stbi_load(filename.c_str(), &image.width, &image.height, 
+			&image.channels, 0);
+		if (!image.data)
+			cout << "Texture failed to load at path: " << endl << filename << endl;
+		lock_guard<mutex> lock(decoded_mutex);
+		decoded.push_back(image);
+	});
+	return ID;
+}
+
+void TextureCache::update()
+{
+	vector<DecodedImage> batch;
+	{
+		lock_guard<mutex> lock(decoded_mutex);
+		if (decoded.empty())
+			return;
+		//take images from the front until the budget is used up, the rest stay queued
+		unsigned int bytes = 0;
+		unsigned int num = 0;
+		while (num < decoded.size() && (num == 0 || bytes < upload_budget))
+		{
+			bytes += decoded[num].width * decoded[num].height * decoded[num].channels;
+			num++;
+		}
+		batch.reserve(num);
+		for (unsigned int i = 0; i < num; i ++)
+		{
+			batch.push_back(decoded.front());
+			decoded.pop_front();
+		}
+	}
+
+	for (unsigned int i = 0; i < batch.size(); i ++)
+	{
+		DecodedImage &image = batch[i];
+		//the texture may have been released while it was decoded
+		auto search = textures.find(image.key);
+		if (search != textures.end() && search->second.ID == image.ID && search->second.pending)
+		{
+			if (image.data)
+				upload(image.ID, image.data, image.width, image.height, image.channels);
+			search->second.pending = false;
+			pending_count--;
+		}
+		stbi_image_free(image.data);
+	}
+}
+
+void TextureCache::upload(unsigned int ID, const unsigned char *data, int width, int height,
+	int channels)
+{
+	GLenum format;
+	if (channels == 1)
+		format = GL_RED;
+	else if (channels == 2)
+		format = GL_RG;
+	else if (channels == 3)
+		format = GL_RGB;
+	else
+		format = GL_RGBA;
+
+	GLState::bindTexture(0, ID);
+	//rows decoded by stb_image are tightly packed, they are not aligned to 4 bytes
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
+	glGenerateMipmap(GL_TEXTURE_2D);
+	//configure texture parameters
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+}
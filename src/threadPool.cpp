@@ -0,0 +1,52 @@
+#include "../include/threadPool.h"
+
+using namespace std;
+
+ThreadPool::ThreadPool(unsigned int threads) : stop(false)
+{
+	if (threads == 0)
+	{
+		//hardware_concurrency may return 0 if it is unknown
+		unsigned int hardware = thread::hardware_concurrency();
+		threads = hardware > 1 ? hardware - 1 : 1;
+	}
+	for (unsigned int i = 0; i < threads; i ++)
+		workers.push_back(thread(&ThreadPool::work, this));
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		lock_guard<mutex> lock(jobs_mutex);
+		stop = true;
+	}
+	condition.notify_all();
+	for (unsigned int i = 0; i < workers.size(); i ++)
+		workers[i].join();
+}
+
+void ThreadPool::push(function<void()> job)
+{
+	{
+		lock_guard<mutex> lock(jobs_mutex);
+		jobs.push(job);
+	}
+	condition.notify_one();
+}
+
+void ThreadPool::work()
+{
+	while (true)
+	{
+		function<void()> job;
+		{
+			unique_lock<mutex> lock(jobs_mutex);
+			condition.wait(lock, [this]{return stop || !jobs.empty();});
+			if (stop)
+				return;
+			job = jobs.front();
+			jobs.pop();
+		}
+		job();
+	}
+}
@@ -0,0 +1,88 @@
+#include "../include/transformBuffer.h"
+#include <cstring>
+#include <algorithm>
+
+using namespace std;
+using namespace glm;
+
+TransformBuffer::TransformBuffer()
+{
+	capacity = 0;
+	current = 0;
+	wait_count = 0;
+	glGenBuffers(TRANSFORM_BUFFER_FRAMES, buffers);
+	glGenTextures(TRANSFORM_BUFFER_FRAMES, textures);
+	for (unsigned int i = 0; i < TRANSFORM_BUFFER_FRAMES; i ++)
+		fences[i] = NULL;
+}
+
+TransformBuffer::~TransformBuffer()
+{
+	for (unsigned int i = 0; i < TRANSFORM_BUFFER_FRAMES; i ++)
+	{
+		if (fences[i])
+			glDeleteSync(fences[i]);
+		GLState::textureDeleted(textures[i]);
+	}
+	glDeleteTextures(TRANSFORM_BUFFER_FRAMES, textures);
+	glDeleteBuffers(TRANSFORM_BUFFER_FRAMES, buffers);
+}
+
+void TransformBuffer::upload(const vector<mat4> &transforms)
+{
+	current = (current + 1) % TRANSFORM_BUFFER_FRAMES;
+	glBindBuffer(GL_TEXTURE_BUFFER, buffers[current]);
+
+	if (transforms.size() > capacity)
+	{
+		//every buffer is reallocated, the driver keeps old storage alive for draws in flight
+		capacity = std::max((unsigned int)transforms.size(), capacity * 2);
+		for (unsigned int i = 0; i < TRANSFORM_BUFFER_FRAMES; i ++)
+		{
+			glBindBuffer(GL_TEXTURE_BUFFER, buffers[i]);
+			glBufferData(GL_TEXTURE_BUFFER, capacity * sizeof(mat4), NULL, GL_STREAM_DRAW);
+			GLState::bindTexture(TRANSFORMS_TEXTURE_UNIT, textures[i], GL_TEXTURE_BUFFER);
+			glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, buffers[i]);
+			if (fences[i])
+			{
+				glDeleteSync(fences[i]);
+				fences[i] = NULL;
+			}
+		}
+		glBindBuffer(GL_TEXTURE_BUFFER, buffers[current]);
+	}
+
+	//wait until the GPU finished the frame that used this buffer last time
+	if (fences[current])
+	{
+		if (glClientWaitSync(fences[current], 0, 0) == GL_TIMEOUT_EXPIRED)
+		{
+			wait_count++;
+			glClientWaitSync(fences[current], GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+		}
+		glDeleteSync(fences[current]);
+		fences[current] = NULL;
+	}
+
+	if (!transforms.empty())
+	{
+		//the fence guarantees the buffer is idle, so the driver doesn't need to synchronize
+		void *ptr = glMapBufferRange(GL_TEXTURE_BUFFER, 0, transforms.size() * sizeof(mat4),
+			GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+		if (ptr)
+		{
+			memcpy(ptr, transforms.data(), transforms.size() * sizeof(mat4));
+			glUnmapBuffer(GL_TEXTURE_BUFFER);
+		}
+	}
+	glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+	GLState::bindTexture(TRANSFORMS_TEXTURE_UNIT, textures[current], GL_TEXTURE_BUFFER);
+}
+
+void TransformBuffer::fence()
+{
+	if (fences[current])
+		glDeleteSync(fences[current]);
+	fences[current] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
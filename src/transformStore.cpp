@@ -0,0 +1,187 @@
+#include "../include/transformStore.h"
+#include <cmath>
+
+#if GLM_ARCH & GLM_ARCH_SSE2_BIT
+#include <emmintrin.h>
+#endif
+
+using namespace std;
+using namespace glm;
+
+unsigned int TransformStore::add()
+{
+	unsigned int index;
+	if (!free_indices.empty())
+	{
+		index = free_indices.back();
+		free_indices.pop_back();
+	}
+	else
+	{
+		index = count++;
+		if (count > pos_x.size())
+		{
+			//arrays are grown 4 at a time so that rebuild() never reads past them
+			unsigned int size = pos_x.size() + 4;
+			pos_x.resize(size); pos_y.resize(size); pos_z.resize(size);
+			axis_x.resize(size); axis_y.resize(size); axis_z.resize(size, 1.0f);
+			angle.resize(size);
+			scale_x.resize(size, 1.0f); scale_y.resize(size, 1.0f); scale_z.resize(size, 1.0f);
+			matrices.resize(size, mat4(1.0f));
+			dirty.resize((size + 63) / 64, 0);
+		}
+	}
+
+	pos_x[index] = pos_y[index] = pos_z[index] = 0.0f;
+	axis_x[index] = axis_y[index] = 0.0f;
+	axis_z[index] = 1.0f;
+	angle[index] = 0.0f;
+	scale_x[index] = scale_y[index] = scale_z[index] = 1.0f;
+	markDirty(index);
+	return index;
+}
+
+void TransformStore::remove(unsigned int index)
+{
+	dirty[index >> 6] &= ~((uint64_t)1 << (index & 63));
+	free_indices.push_back(index);
+}
+
+void TransformStore::setPosition(unsigned int index, const vec3 &pos)
+{
+	pos_x[index] = pos.x;
+	pos_y[index] = pos.y;
+	pos_z[index] = pos.z;
+	markDirty(index);
+}
+
+void TransformStore::setRotation(unsigned int index, float degrees, const vec3 &axis)
+{
+	float len = length(axis);
+	//a zero axis can't be normalized, treat it as no rotation
+	vec3 a = len > 0.0f ? axis / len : vec3(0.0f, 0.0f, 1.0f);
+	axis_x[index] = a.x;
+	axis_y[index] = a.y;
+	axis_z[index] = a.z;
+	angle[index] = len > 0.0f ? radians(degrees) : 0.0f;
+	markDirty(index);
+}
+
+void TransformStore::setScale(unsigned int index, const vec3 &scale)
+{
+	scale_x[index] = scale.x;
+	scale_y[index] = scale.y;
+	scale_z[index] = scale.z;
+	markDirty(index);
+}
+
+unsigned int TransformStore::update(vector<unsigned int> &changed)
+{
+	unsigned int rebuilt = 0;
+	for (unsigned int w = 0; w < dirty.size(); w ++)
+	{
+		uint64_t bits = dirty[w];
+		while (bits)
+		{
+			//lowest dirty transformation and the group of 4 containing it
+			unsigned int bit = 0;
+			while (!(bits >> bit & 1))
+				bit ++;
+			unsigned int group = bit & ~3u;
+			unsigned int first = w * 64 + group;
+			uint64_t group_bits = bits & ((uint64_t)0xf << group);
+			//a single changed transformation is not worth rebuilding 4
+			if (group_bits & (group_bits - 1))
+				rebuild(first);
+			else
+				rebuild(first + (bit - group), 1);
+
+			for (unsigned int i = 0; i < 4; i ++)
+			{
+				if (group_bits >> (group + i) & 1)
+				{
+					changed.push_back(first + i);
+					rebuilt++;
+				}
+			}
+			bits &= ~group_bits;
+		}
+		dirty[w] = 0;
+	}
+	return rebuilt;
+}
+
+void TransformStore::rebuild(unsigned int first, unsigned int num)
+{
+	//sine and cosine have no SSE instruction
+	float s[4], c[4];
+	for (unsigned int i = 0; i < num; i ++)
+	{
+		s[i] = std::sin(angle[first + i]);
+		c[i] = std::cos(angle[first + i]);
+	}
+
+#if GLM_ARCH & GLM_ARCH_SSE2_BIT
+	if (num == 4)
+	{
+		//each register holds one matrix element of 4 transformations
+		__m128 ax = _mm_loadu_ps(&axis_x[first]);
+		__m128 ay = _mm_loadu_ps(&axis_y[first]);
+		__m128 az = _mm_loadu_ps(&axis_z[first]);
+		__m128 vsin = _mm_loadu_ps(s);
+		__m128 vcos = _mm_loadu_ps(c);
+		__m128 one = _mm_set1_ps(1.0f);
+		__m128 zero = _mm_setzero_ps();
+		//rotation around an axis, same terms as glm::rotate
+		__m128 t = _mm_sub_ps(one, vcos);
+		__m128 tx = _mm_mul_ps(t, ax);
+		__m128 ty = _mm_mul_ps(t, ay);
+		__m128 tz = _mm_mul_ps(t, az);
+		__m128 sx = _mm_loadu_ps(&scale_x[first]);
+		__m128 sy = _mm_loadu_ps(&scale_y[first]);
+		__m128 sz = _mm_loadu_ps(&scale_z[first]);
+
+		//columns of the matrices, the rotation is scaled column by column
+		__m128 col[4][4];
+		col[0][0] = _mm_mul_ps(_mm_add_ps(vcos, _mm_mul_ps(tx, ax)), sx);
+		col[0][1] = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(tx, ay), _mm_mul_ps(vsin, az)), sx);
+		col[0][2] = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(tx, az), _mm_mul_ps(vsin, ay)), sx);
+		col[0][3] = zero;
+		col[1][0] = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(ty, ax), _mm_mul_ps(vsin, az)), sy);
+		col[1][1] = _mm_mul_ps(_mm_add_ps(vcos, _mm_mul_ps(ty, ay)), sy);
+		col[1][2] = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(ty, az), _mm_mul_ps(vsin, ax)), sy);
+		col[1][3] = zero;
+		col[2][0] = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(tz, ax), _mm_mul_ps(vsin, ay)), sz);
+		col[2][1] = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(tz, ay), _mm_mul_ps(vsin, ax)), sz);
+		col[2][2] = _mm_mul_ps(_mm_add_ps(vcos, _mm_mul_ps(tz, az)), sz);
+		col[2][3] = zero;
+		col[3][0] = _mm_loadu_ps(&pos_x[first]);
+		col[3][1] = _mm_loadu_ps(&pos_y[first]);
+		col[3][2] = _mm_loadu_ps(&pos_z[first]);
+		col[3][3] = one;
+
+		//after transposing, register i holds the column of transformation i
+		for (unsigned int j = 0; j < 4; j ++)
+		{
+			_MM_TRANSPOSE4_PS(col[j][0], col[j][1], col[j][2], col[j][3]);
+			for (unsigned int i = 0; i < 4; i ++)
+				_mm_storeu_ps(&matrices[first + i][j][0], col[j][i]);
+		}
+		return;
+	}
+#endif
+	for (unsigned int i = 0; i < num; i ++)
+	{
+		unsigned int k = first + i;
+		vec3 a(axis_x[k], axis_y[k], axis_z[k]);
+		vec3 t = (1.0f - c[i]) * a;
+		mat4 &m = matrices[k];
+		m[0] = vec4(c[i] + t.x * a.x, t.x * a.y + s[i] * a.z, t.x * a.z - s[i] * a.y, 0.0f) *
+			scale_x[k];
+		m[1] = vec4(t.y * a.x - s[i] * a.z, c[i] + t.y * a.y, t.y * a.z + s[i] * a.x, 0.0f) *
+			scale_y[k];
+		m[2] = vec4(t.z * a.x + s[i] * a.y, t.z * a.y - s[i] * a.x, c[i] + t.z * a.z, 0.0f) *
+			scale_z[k];
+		m[3] = vec4(pos_x[k], pos_y[k], pos_z[k], 1.0f);
+	}
+}